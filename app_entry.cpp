@@ -1,9 +1,128 @@
 #include <windows.h>
+#include <shellapi.h>
 
+#include "sys_perturb.h"
+#include "sys_thread_policy.h"
 #include "ui_app.h"
 
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static std::string narrow(const wchar_t* ws) {
+	std::string s;
+	for (; *ws; ++ws) s.push_back(*ws < 0x80 ? static_cast<char>(*ws) : '?');
+	return s;
+}
+
+struct Options {
+	std::uint64_t housekeeping{}; // --low-perturbation <cores>
+	bool bench{};                 // --perturbation-bench <spin core> [seconds]
+	unsigned spinCore{};
+	std::uint32_t phaseSec{};
+};
+
+static bool parseUnsigned(const wchar_t* s, unsigned long& out) {
+	wchar_t* end = nullptr;
+	out = std::wcstoul(s, &end, 10);
+	return end != s && *end == L'\0';
+}
+
+// Every argument is parsed before anything runs, so options combine in any
+// order. Keeps going past a bad one so opt.bench still says where to report
+// it; returns false with the first problem in `error`.
+static bool parseOptions(int argc, wchar_t** argv, Options& opt, std::wstring& error) {
+	auto fail = [&error](const std::wstring& msg) {
+		if (error.empty()) error = msg;
+	};
+	unsigned long v = 0;
+	for (int i = 1; i < argc; ++i) {
+		const std::wstring arg = argv[i];
+		if (arg == L"--low-perturbation") {
+			if (i + 1 >= argc || !sysmon::parseCoreSet(narrow(argv[i + 1]), opt.housekeeping)) {
+				fail(L"--low-perturbation needs a core set such as 0,1 or 0-3 (cores 0-63).");
+			}
+			++i;
+		} else if (arg == L"--perturbation-bench") {
+			opt.bench = true;
+			if (i + 1 >= argc || !parseUnsigned(argv[i + 1], v) || v > 63) {
+				fail(L"usage: SysMonitor --perturbation-bench <spin core> [seconds]");
+				continue;
+			}
+			opt.spinCore = static_cast<unsigned>(v);
+			++i;
+			if (i + 1 < argc && parseUnsigned(argv[i + 1], v)) {
+				opt.phaseSec = static_cast<std::uint32_t>(v);
+				++i;
+			}
+		} else {
+			fail(L"Unknown option: " + arg);
+		}
+	}
+	return error.empty();
+}
+
+// The benchmark reports to the console the program was started from.
+static void attachParentConsole() {
+	if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+		FILE* f = nullptr;
+		freopen_s(&f, "CONOUT$", "w", stdout);
+	}
+}
+
+static int runBench(const sysmon::UiAppConfig& cfg, const Options& opt) {
+	sysmon::PerturbBenchConfig bench;
+	bench.spinCore = opt.spinCore;
+	bench.phaseMs = (opt.phaseSec ? opt.phaseSec : 10) * 1000;
+	bench.housekeepingMask = opt.housekeeping;
+	bench.sampler = cfg.sampler;
+	std::printf("%s", sysmon::runPerturbationBench(bench).c_str());
+	std::fflush(stdout);
+	return 0;
+}
+
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int) {
 	sysmon::UiAppConfig cfg;
 	cfg.defaultPort = 6666;
+
+	int argc = 0;
+	wchar_t** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	Options opt;
+	std::wstring error;
+	const bool parsed = !argv || parseOptions(argc, argv, opt, error);
+	const bool bench = opt.bench;
+	if (argv) LocalFree(argv);
+
+	// A mistyped core set must not silently run unpinned: refuse to start.
+	if (!parsed) {
+		if (bench) {
+			attachParentConsole();
+			std::printf("%ls\n", error.c_str());
+		} else {
+			MessageBoxW(nullptr, error.c_str(), L"SysMonitor", MB_OK | MB_ICONERROR);
+		}
+		return 2;
+	}
+
+	// --low-perturbation: the sampler and server threads are pinned to the
+	// housekeeping cores at background priority and batch each tick's
+	// queries; the tray app additionally confines the whole process there.
+	if (opt.housekeeping) {
+		sysmon::ThreadPolicy policy;
+		policy.affinityMask = opt.housekeeping;
+		policy.background = true;
+		cfg.sampler.thread = policy;
+		cfg.sampler.batchQueries = true;
+		cfg.serverPolicy = policy;
+	}
+
+	if (bench) {
+		// The benchmark spins a core outside the housekeeping set, so only
+		// its monitor threads take the policy, not the process.
+		attachParentConsole();
+		return runBench(cfg, opt);
+	}
+	if (opt.housekeeping) sysmon::applyProcessPolicy(cfg.serverPolicy);
 	return sysmon::RunTrayApp(hInstance, cfg);
 }
@@ -0,0 +1,114 @@
+#include "clock_sync.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace sysmon {
+
+static std::int64_t offsetOf(const PingExchange& ex) {
+	return ((ex.t2 - ex.t1) + (ex.t3 - ex.t4)) / 2;
+}
+
+static std::int64_t delayOf(const PingExchange& ex) {
+	return (ex.t4 - ex.t1) - (ex.t3 - ex.t2);
+}
+
+std::string formatPing(std::int64_t t1) {
+	char buf[48];
+	std::snprintf(buf, sizeof(buf), "PING %" PRId64 "\r\n", t1);
+	return buf;
+}
+
+std::string formatPong(std::int64_t t1, std::int64_t t2, std::int64_t t3) {
+	char buf[96];
+	std::snprintf(buf, sizeof(buf), "PONG %" PRId64 " %" PRId64 " %" PRId64 "\r\n", t1, t2, t3);
+	return buf;
+}
+
+static bool parseI64(const char*& p, std::int64_t& out) {
+	while (*p == ' ') ++p;
+	char* end = nullptr;
+	errno = 0;
+	const long long v = std::strtoll(p, &end, 10);
+	if (end == p || errno == ERANGE) return false;
+	out = static_cast<std::int64_t>(v);
+	p = end;
+	return true;
+}
+
+bool parsePing(const std::string& cmd, std::int64_t& t1) {
+	if (cmd.compare(0, 5, "PING ") != 0) return false;
+	const char* p = cmd.c_str() + 5;
+	std::int64_t v = 0;
+	if (!parseI64(p, v)) return false;
+	while (*p == ' ') ++p;
+	if (*p) return false;
+	t1 = v;
+	return true;
+}
+
+bool parsePong(const std::string& line, std::int64_t t4, PingExchange& out) {
+	if (line.compare(0, 5, "PONG ") != 0) return false;
+	const char* p = line.c_str() + 5;
+	PingExchange ex;
+	if (!parseI64(p, ex.t1) || !parseI64(p, ex.t2) || !parseI64(p, ex.t3)) return false;
+	while (*p == ' ' || *p == '\r' || *p == '\n') ++p;
+	if (*p) return false;
+	ex.t4 = t4;
+	out = ex;
+	return true;
+}
+
+ClockSync::ClockSync(std::size_t window) : _window(window ? window : 1) {
+	_ring.reserve(_window);
+}
+
+void ClockSync::add(const PingExchange& ex) {
+	if (delayOf(ex) < 0) return;
+	if (_ring.size() < _window) {
+		_ring.push_back(ex);
+	} else {
+		_ring[_next] = ex;
+	}
+	_next = (_next + 1) % _window;
+}
+
+void ClockSync::reset() {
+	_ring.clear();
+	_next = 0;
+}
+
+ClockEstimate ClockSync::estimate() const {
+	ClockEstimate est;
+	if (_ring.empty()) return est;
+
+	const PingExchange* best = &_ring[0];
+	for (const auto& ex : _ring) {
+		if (delayOf(ex) < delayOf(*best)) best = &ex;
+	}
+	est.valid = true;
+	est.offsetNs = offsetOf(*best);
+	est.delayNs = delayOf(*best);
+
+	if (_ring.size() > 1) {
+		double sum = 0.0;
+		for (const auto& ex : _ring) {
+			const double d = static_cast<double>(offsetOf(ex) - est.offsetNs);
+			sum += d * d;
+		}
+		est.jitterNs = static_cast<std::int64_t>(std::sqrt(sum / static_cast<double>(_ring.size() - 1)));
+	}
+	return est;
+}
+
+bool ClockSync::serverToClient(std::int64_t serverMonoNs, std::int64_t& clientNs) const {
+	const ClockEstimate est = estimate();
+	if (!est.valid) return false;
+	clientNs = serverMonoNs - est.offsetNs;
+	return true;
+}
+
+} // namespace sysmon
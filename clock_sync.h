@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sysmon {
+
+// Clock offset between a client and the server's monotonic clock, estimated
+// from PING/PONG exchanges on the monitor connection. Portable: clients on
+// any OS can build this file alone.
+//
+// Wire format (one line each way):
+//   client -> server  "PING <t1>"
+//   server -> client  "PONG <t1> <t2> <t3>"
+// t1 is the client's send time echoed back unchanged, t2/t3 are the
+// server's receive/transmit times in its monotonic nanoseconds, the same
+// clock as "mono_ns" in every streamed sample. The client notes t4 when the
+// reply arrives. All values are decimal integers.
+
+struct PingExchange {
+	std::int64_t t1{}; // client send, client clock
+	std::int64_t t2{}; // server receive, server monotonic ns
+	std::int64_t t3{}; // server transmit, server monotonic ns
+	std::int64_t t4{}; // client receive, client clock
+};
+
+struct ClockEstimate {
+	bool valid{};
+	// serverMono - clientClock at the same instant.
+	std::int64_t offsetNs{};
+	// Round trip minus server processing time of the exchange the estimate came from.
+	std::int64_t delayNs{};
+	// RMS spread of the other kept exchanges' offsets around offsetNs.
+	std::int64_t jitterNs{};
+};
+
+std::string formatPing(std::int64_t t1);
+std::string formatPong(std::int64_t t1, std::int64_t t2, std::int64_t t3);
+// Parses a PING command line (no line terminator) into the client's t1.
+bool parsePing(const std::string& cmd, std::int64_t& t1);
+// Parses a PONG line (trailing "\r\n" allowed) and stamps it with t4.
+bool parsePong(const std::string& line, std::int64_t t4, PingExchange& out);
+
+// NTP-style clock filter: keeps the last `window` exchanges and trusts the
+// one with the smallest round-trip delay, since queueing only ever adds
+// delay and the least-delayed exchange has the least asymmetric error.
+class ClockSync {
+public:
+	explicit ClockSync(std::size_t window = 8);
+
+	// Exchanges with a negative delay (clock stepped mid-exchange) are ignored.
+	void add(const PingExchange& ex);
+	void reset();
+
+	ClockEstimate estimate() const;
+	// Maps a server "mono_ns" onto the client clock using the current
+	// estimate; false (clientNs untouched) until an exchange has been kept.
+	bool serverToClient(std::int64_t serverMonoNs, std::int64_t& clientNs) const;
+
+private:
+	std::vector<PingExchange> _ring;
+	std::size_t _window;
+	std::size_t _next{};
+};
+
+} // namespace sysmon
@@ -1,29 +1,129 @@
 #include "network_server.h"
 
+#include "clock_sync.h"
+#include "sys_alloc_guard.h"
+#include "sys_clock.h"
+#include "token_bucket.h"
+
 #include <windows.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cstdio>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #pragma comment(lib, "ws2_32.lib")
 
 namespace sysmon {
 
+static constexpr size_t kMaxCommandLine = 256;
+static constexpr size_t kMaxPendingEvents = 256;
+// Initial capacity of each per-encoding line, so steady-state ticks never grow it.
+static constexpr size_t kLineReserve = 8192;
+// One wait slot goes to the wake event and one to the listening socket.
+static constexpr size_t kMaxClients = WSA_MAXIMUM_WAIT_EVENTS - 2;
+
+struct SourceState {
+	TokenBucket connects;
+	TokenBucket commands;
+	size_t active{};
+};
+
+struct AdmissionStats {
+	std::uint64_t accepted{};
+	std::uint64_t rejectedFull{};
+	std::uint64_t rejectedRate{};
+	std::uint64_t rejectedSources{};
+	std::uint64_t commandsDropped{};
+};
+
+struct OutboundStats {
+	std::uint64_t linesDropped{};
+	std::uint64_t slowClosed{};
+};
+
+struct ClientConn {
+	SOCKET sock{ INVALID_SOCKET };
+	std::uint32_t source{};
+	WSAEVENT ev{ WSA_INVALID_EVENT };
+	std::string inbuf;
+	// Bytes the socket has not taken yet, flushed on FD_WRITE. Reserved to
+	// limits.maxOutboundBytes at accept, so queueing never allocates.
+	std::string outbuf;
+	Encoding encoding{ Encoding::Text };
+	bool alerts{};
+	bool dead{};
+	std::uint64_t lastTick{};
+};
+
+// Rendered form of one tick in one encoding, shared by all clients using it.
+struct EncodedTick {
+	std::uint64_t tick{ ~0ULL };
+	std::string line;
+};
+
 struct NetworkServer::Impl {
 	std::uint16_t port{};
 	LineProvider provider;
+	CommandHandler commands;
+	AlertReplay alertReplay;
+	ServerLimits limits;
 	WSADATA wsa{};
 	SOCKET listening{ INVALID_SOCKET };
+	WSAEVENT listenEvent{ WSA_INVALID_EVENT };
 	std::atomic<bool> stopping{ false };
+
+	// Signalled by notifyTick(), pushEvent() and stop() to wake the loop.
+	HANDLE wake{};
+	std::atomic<std::uint64_t> tickSeq{ 0 };
+	std::mutex eventsMutex;
+	std::vector<std::string> events;
+	std::vector<std::string> pending; // swapped with `events`; loop thread only
+	std::atomic<bool> hasSubscriber{ false };
+
+	std::vector<ClientConn> clients;
+	EncodedTick encoded[kEncodingCount];
+
+	// Only touched by the loop thread (the accept condition runs inside WSAAccept).
+	std::unordered_map<std::uint32_t, SourceState> sources;
+	AdmissionStats admission;
+	OutboundStats outbound;
+
+	static int CALLBACK admitCondition(LPWSABUF callerId, LPWSABUF, LPQOS, LPQOS, LPWSABUF, LPWSABUF, GROUP*, DWORD_PTR self);
+	bool admit(std::uint32_t source);
+	void pruneSources(ULONGLONG nowMs);
+	std::string formatStats() const;
+
+	void acceptClients();
+	void closeClient(ClientConn& c);
+	bool flush(ClientConn& c);
+	bool sendLine(ClientConn& c, const std::string& line, bool droppable = false);
+	void handleWake();
+	const std::string* encodedLine(Encoding e, std::uint64_t tick);
+	bool readCommands(ClientConn& c);
+	bool handleCommand(ClientConn& c, const std::string& cmd, std::uint64_t rxNs);
+	void updateSubscribers();
 };
 
-NetworkServer::NetworkServer(std::uint16_t port, LineProvider provider) : _impl(new Impl{}) {
+NetworkServer::NetworkServer(std::uint16_t port, LineProvider provider, const ServerLimits& limits) : _impl(new Impl{}) {
 	_impl->port = port;
 	_impl->provider = std::move(provider);
+	_impl->limits = limits;
+	_impl->limits.maxClients = std::min(std::max<size_t>(_impl->limits.maxClients, 1), kMaxClients);
+	_impl->wake = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	// Everything the per-tick path touches is sized here, before the loop
+	// arms the allocation guard.
+	_impl->clients.reserve(_impl->limits.maxClients);
+	_impl->events.reserve(kMaxPendingEvents);
+	_impl->pending.reserve(kMaxPendingEvents);
+	for (auto& slot : _impl->encoded) slot.line.reserve(kLineReserve);
 }
 
 NetworkServer::~NetworkServer() {
@@ -31,32 +131,336 @@ NetworkServer::~NetworkServer() {
 
 	if (!_impl) return;
 	WSACleanup();
+	if (_impl->wake) CloseHandle(_impl->wake);
 	delete _impl;
 	_impl = nullptr;
 }
 
+// The loop owns every socket and closes them on its way out; stop() only
+// asks it to leave.
 void NetworkServer::stop() noexcept {
 	if (!_impl) return;
 
 	_impl->stopping.store(true, std::memory_order_release);
+	if (_impl->wake) SetEvent(_impl->wake);
+}
 
-	if (_impl->listening != INVALID_SOCKET) {
-		shutdown(_impl->listening, SD_BOTH);
-		closesocket(_impl->listening);
-		_impl->listening = INVALID_SOCKET;
+void NetworkServer::setCommandHandler(CommandHandler handler) {
+	if (_impl) _impl->commands = std::move(handler);
+}
+
+void NetworkServer::setAlertReplay(AlertReplay replay) {
+	if (_impl) _impl->alertReplay = std::move(replay);
+}
+
+void NetworkServer::notifyTick() {
+	if (!_impl) return;
+	_impl->tickSeq.fetch_add(1, std::memory_order_release);
+	SetEvent(_impl->wake);
+}
+
+void NetworkServer::pushEvent(const std::string& line) {
+	if (!_impl || !_impl->hasSubscriber.load(std::memory_order_acquire)) return;
+	{
+		std::lock_guard<std::mutex> lock(_impl->eventsMutex);
+		if (_impl->events.size() >= kMaxPendingEvents) return;
+		_impl->events.push_back(line);
+	}
+	SetEvent(_impl->wake);
+}
+
+static void reportSendFailure(ClientConn& c) {
+	AllocGuardExempt exempt;
+	int err = WSAGetLastError();
+	// Normal behavior when client disconnects
+	if (err != 0) std::cerr << "Client send failed: " << err << "\n";
+	c.dead = true;
+}
+
+// Client sockets are non-blocking once bound to an event (WSAEventSelect).
+// Sends what the socket takes and keeps the rest; FD_WRITE calls back here
+// once there is room again, so the loop never waits on one client.
+bool NetworkServer::Impl::flush(ClientConn& c) {
+	size_t total = 0;
+	while (total < c.outbuf.size()) {
+		int sent = send(c.sock, c.outbuf.data() + total, static_cast<int>(c.outbuf.size() - total), 0);
+		if (sent == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK) break;
+		if (sent == SOCKET_ERROR || sent == 0) {
+			reportSendFailure(c);
+			return false;
+		}
+		total += static_cast<size_t>(sent);
+	}
+	c.outbuf.erase(0, total);
+	return true;
+}
+
+// Stream lines are droppable: a client too slow for them skips ticks. Losing
+// a reply or an alert would desynchronize the protocol, so those close it.
+bool NetworkServer::Impl::sendLine(ClientConn& c, const std::string& line, bool droppable) {
+	if (c.dead) return false;
+	if (c.outbuf.size() + line.size() > limits.maxOutboundBytes) {
+		if (droppable) {
+			++outbound.linesDropped;
+			return true;
+		}
+		++outbound.slowClosed;
+		c.dead = true;
+		return false;
+	}
+	c.outbuf.append(line);
+	return flush(c);
+}
+
+static void normalizeLine(std::string& line) {
+	if (line.empty()) {
+		line = "\r\n";
+		return;
+	}
+	if (line.size() >= 2 && line.compare(line.size() - 2, 2, "\r\n") == 0) return;
+	if (line.back() == '\n') {
+		// normalize \n -> \r\n
+		line.insert(line.end() - 1, '\r');
+	} else {
+		line += "\r\n";
+	}
+}
+
+const std::string* NetworkServer::Impl::encodedLine(Encoding e, std::uint64_t tick) {
+	EncodedTick& slot = encoded[static_cast<size_t>(e)];
+	if (slot.tick == tick) return &slot.line;
+
+	try {
+		slot.line.clear();
+		if (provider) provider(e, slot.line);
+	} catch (const std::exception& ex) {
+		AllocGuardExempt exempt;
+		std::cerr << "Exception in provider: " << ex.what() << "\n";
+		return nullptr;
+	} catch (...) {
+		AllocGuardExempt exempt;
+		std::cerr << "Unknown exception in provider.\n";
+		return nullptr;
+	}
+	// A binary frame is sent as is; a trailing 0x0a byte is data, not a line end.
+	if (e != Encoding::Binary) normalizeLine(slot.line);
+	slot.tick = tick;
+	return &slot.line;
+}
+
+void NetworkServer::Impl::updateSubscribers() {
+	const bool any = std::any_of(clients.begin(), clients.end(), [](const ClientConn& c) { return c.alerts && !c.dead; });
+	hasSubscriber.store(any, std::memory_order_release);
+}
+
+// rxNs is when the bytes carrying cmd were read, for PING's receive timestamp.
+bool NetworkServer::Impl::handleCommand(ClientConn& c, const std::string& cmd, std::uint64_t rxNs) {
+	std::string reply;
+	Encoding enc{};
+	std::int64_t t1 = 0;
+	if (parsePing(cmd, t1)) {
+		// Answered before anything else so the transmit stamp is taken as
+		// close to send() as possible.
+		const std::string pong = formatPong(t1, static_cast<std::int64_t>(rxNs), static_cast<std::int64_t>(monotonicNs()));
+		return sendLine(c, pong);
+	}
+	if (cmd == "SUBSCRIBE ALERT") {
+		c.alerts = true;
+		reply = "OK\r\n";
+		if (alertReplay) alertReplay(reply);
+	} else if (cmd == "UNSUBSCRIBE ALERT") {
+		c.alerts = false;
+		reply = "OK\r\n";
+	} else if (cmd.compare(0, 9, "ENCODING ") == 0) {
+		if (parseEncoding(cmd.substr(9), enc)) {
+			c.encoding = enc;
+			reply = "OK\r\n";
+			if (enc == Encoding::Csv) reply += csvHeader();
+			if (enc == Encoding::Binary) reply += wireSchema();
+		} else {
+			reply = "ERR unknown encoding\r\n";
+		}
+	} else if (cmd == "STATS NET") {
+		reply = formatStats();
+	} else if (!commands || !commands(cmd, reply)) {
+		reply = "ERR unknown command\r\n";
+	}
+	updateSubscribers();
+	normalizeLine(reply);
+	return sendLine(c, reply);
+}
+
+bool NetworkServer::Impl::readCommands(ClientConn& c) {
+	AllocGuardExempt exempt;
+	char buf[512];
+	for (;;) {
+		int n = recv(c.sock, buf, sizeof(buf), 0);
+		if (n == 0) return false;
+		if (n == SOCKET_ERROR) return WSAGetLastError() == WSAEWOULDBLOCK;
+		const std::uint64_t rxNs = monotonicNs();
+		c.inbuf.append(buf, static_cast<size_t>(n));
+
+		size_t eol;
+		while ((eol = c.inbuf.find('\n')) != std::string::npos) {
+			std::string cmd = c.inbuf.substr(0, eol);
+			c.inbuf.erase(0, eol + 1);
+			while (!cmd.empty() && (cmd.back() == '\r' || cmd.back() == ' ')) cmd.pop_back();
+			if (cmd.empty()) continue;
+			// Over-budget commands are not run, only answered with a fixed
+			// line, so a flooding client cannot make the server do work on its
+			// behalf while a well-behaved one (e.g. a PING) still hears why.
+			// The answer is droppable: it never grows a slow reader's backlog.
+			auto it = sources.find(c.source);
+			if (it != sources.end() && !it->second.commands.take(limits.commandsPerSec, limits.commandBurst, GetTickCount64())) {
+				++admission.commandsDropped;
+				static const std::string kRateLimited = "ERR rate limited\r\n";
+				if (!sendLine(c, kRateLimited, true)) return false;
+				continue;
+			}
+			if (!handleCommand(c, cmd, rxNs)) return false;
+		}
+		// A client that never sends a newline is not allowed to grow the buffer.
+		if (c.inbuf.size() > kMaxCommandLine) c.inbuf.clear();
 	}
 }
 
-static bool sendAll(SOCKET s, const char* data, int len) {
-	int total = 0;
-	while (total < len) {
-		int sent = send(s, data + total, len - total, 0);
-		if (sent == SOCKET_ERROR || sent == 0) return false;
-		total += sent;
+void NetworkServer::Impl::handleWake() {
+	{
+		std::lock_guard<std::mutex> lock(eventsMutex);
+		pending.swap(events);
+		ResetEvent(wake);
+	}
+
+	const std::uint64_t tick = tickSeq.load(std::memory_order_acquire);
+	for (auto& c : clients) {
+		if (c.dead) continue;
+		if (c.alerts) {
+			for (const auto& line : pending) {
+				if (!sendLine(c, line)) break;
+			}
+		}
+		if (c.dead || c.lastTick == tick) continue;
+		c.lastTick = tick;
+		const std::string* line = encodedLine(c.encoding, tick);
+		if (!line) {
+			c.dead = true;
+			continue;
+		}
+		sendLine(c, *line, true);
+	}
+	pending.clear();
+}
+
+// Drops idle sources whose buckets have refilled; they would start full anyway.
+void NetworkServer::Impl::pruneSources(ULONGLONG nowMs) {
+	for (auto it = sources.begin(); it != sources.end();) {
+		SourceState& src = it->second;
+		src.connects.refill(limits.connectsPerSec, limits.connectBurst, nowMs);
+		src.commands.refill(limits.commandsPerSec, limits.commandBurst, nowMs);
+		if (src.active == 0 && src.connects.tokens >= limits.connectBurst && src.commands.tokens >= limits.commandBurst) {
+			it = sources.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+bool NetworkServer::Impl::admit(std::uint32_t source) {
+	if (clients.size() >= limits.maxClients) {
+		++admission.rejectedFull;
+		return false;
+	}
+
+	const ULONGLONG now = GetTickCount64();
+	auto it = sources.find(source);
+	if (it == sources.end()) {
+		if (sources.size() >= limits.maxSources) pruneSources(now);
+		if (sources.size() >= limits.maxSources) {
+			++admission.rejectedSources;
+			return false;
+		}
+		SourceState fresh;
+		fresh.connects = { limits.connectBurst, now };
+		fresh.commands = { limits.commandBurst, now };
+		it = sources.emplace(source, fresh).first;
+	}
+	if (!it->second.connects.take(limits.connectsPerSec, limits.connectBurst, now)) {
+		++admission.rejectedRate;
+		return false;
 	}
 	return true;
 }
 
+int CALLBACK NetworkServer::Impl::admitCondition(LPWSABUF callerId, LPWSABUF, LPQOS, LPQOS, LPWSABUF, LPWSABUF, GROUP*, DWORD_PTR self) {
+	auto* impl = reinterpret_cast<Impl*>(self);
+	if (!callerId || !callerId->buf || callerId->len < sizeof(sockaddr_in)) return CF_REJECT;
+	const auto* peer = reinterpret_cast<const sockaddr_in*>(callerId->buf);
+	if (peer->sin_family != AF_INET) return CF_REJECT;
+	return impl->admit(ntohl(peer->sin_addr.s_addr)) ? CF_ACCEPT : CF_REJECT;
+}
+
+void NetworkServer::Impl::acceptClients() {
+	AllocGuardExempt exempt;
+	for (;;) {
+		sockaddr_in peer{};
+		int peerLen = sizeof(peer);
+		SOCKET s = WSAAccept(listening, reinterpret_cast<sockaddr*>(&peer), &peerLen, admitCondition, reinterpret_cast<DWORD_PTR>(this));
+		if (s == INVALID_SOCKET) {
+			int err = WSAGetLastError();
+			// Refused by admitCondition; already counted there.
+			if (err == WSAECONNREFUSED) continue;
+			if (err != WSAEWOULDBLOCK) std::cerr << "Error accepting connection: " << err << "\n";
+			return;
+		}
+
+		ClientConn c;
+		c.sock = s;
+		c.source = ntohl(peer.sin_addr.s_addr);
+		c.outbuf.reserve(limits.maxOutboundBytes);
+		c.ev = WSACreateEvent();
+		if (c.ev == WSA_INVALID_EVENT || WSAEventSelect(s, c.ev, FD_READ | FD_WRITE | FD_CLOSE) == SOCKET_ERROR) {
+			std::cerr << "WSAEventSelect failed: " << WSAGetLastError() << "\n";
+			if (c.ev != WSA_INVALID_EVENT) WSACloseEvent(c.ev);
+			closesocket(s);
+			continue;
+		}
+		// The stream starts at the next tick, which leaves the client time to
+		// pick an encoding before its first line.
+		c.lastTick = tickSeq.load(std::memory_order_acquire);
+		++sources[c.source].active;
+		++admission.accepted;
+		clients.push_back(std::move(c));
+		std::cout << "Client connected.\n";
+	}
+}
+
+std::string NetworkServer::Impl::formatStats() const {
+	char buf[320];
+	std::snprintf(buf, sizeof(buf), "NET clients=%zu max_clients=%zu sources=%zu accepted=%llu rejected_full=%llu rejected_rate=%llu rejected_sources=%llu commands_dropped=%llu lines_dropped=%llu slow_closed=%llu\r\n",
+		clients.size(), limits.maxClients, sources.size(),
+		static_cast<unsigned long long>(admission.accepted),
+		static_cast<unsigned long long>(admission.rejectedFull),
+		static_cast<unsigned long long>(admission.rejectedRate),
+		static_cast<unsigned long long>(admission.rejectedSources),
+		static_cast<unsigned long long>(admission.commandsDropped),
+		static_cast<unsigned long long>(outbound.linesDropped),
+		static_cast<unsigned long long>(outbound.slowClosed));
+	return buf;
+}
+
+void NetworkServer::Impl::closeClient(ClientConn& c) {
+	AllocGuardExempt exempt;
+	auto it = sources.find(c.source);
+	if (it != sources.end() && it->second.active) --it->second.active;
+	WSAEventSelect(c.sock, nullptr, 0);
+	WSACloseEvent(c.ev);
+	shutdown(c.sock, SD_BOTH);
+	closesocket(c.sock);
+	c.sock = INVALID_SOCKET;
+	c.ev = WSA_INVALID_EVENT;
+	std::cout << "Client disconnected.\n";
+}
+
 int NetworkServer::run() {
 	if (!_impl) return 1;
 
@@ -77,6 +481,13 @@ int NetworkServer::run() {
 		std::cerr << "setsockopt(SO_REUSEADDR) failed: " << WSAGetLastError() << "\n";
 	}
 
+	// With conditional accept the handshake is only completed once
+	// admitCondition agrees, so refused peers never cost a full connection.
+	BOOL conditional = TRUE;
+	if (setsockopt(_impl->listening, SOL_SOCKET, SO_CONDITIONAL_ACCEPT, reinterpret_cast<const char*>(&conditional), sizeof(conditional)) == SOCKET_ERROR) {
+		std::cerr << "setsockopt(SO_CONDITIONAL_ACCEPT) failed: " << WSAGetLastError() << "\n";
+	}
+
 	sockaddr_in addr{};
 	addr.sin_family = AF_INET;
 	addr.sin_port = htons(_impl->port);
@@ -84,67 +495,91 @@ int NetworkServer::run() {
 
 	if (bind(_impl->listening, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) {
 		std::cerr << "Cannot bind socket: " << WSAGetLastError() << "\n";
+		closesocket(_impl->listening);
+		_impl->listening = INVALID_SOCKET;
 		return 1;
 	}
 
-	// Restrict backlog to 1 to discourage multiple pending connections, 
-	// though the app logic already handles clients sequentially (one at a time).
-	if (listen(_impl->listening, 1) == SOCKET_ERROR) {
+	// Keep the backlog small; connections beyond limits.maxClients are refused anyway.
+	if (listen(_impl->listening, 4) == SOCKET_ERROR) {
 		std::cerr << "Cannot listen on socket: " << WSAGetLastError() << "\n";
+		closesocket(_impl->listening);
+		_impl->listening = INVALID_SOCKET;
 		return 1;
 	}
 
-	std::cout << "Waiting for client on 0.0.0.0:" << _impl->port << "...\n";
+	_impl->listenEvent = WSACreateEvent();
+	if (_impl->listenEvent == WSA_INVALID_EVENT || WSAEventSelect(_impl->listening, _impl->listenEvent, FD_ACCEPT) == SOCKET_ERROR) {
+		std::cerr << "WSAEventSelect(listen) failed: " << WSAGetLastError() << "\n";
+		if (_impl->listenEvent != WSA_INVALID_EVENT) WSACloseEvent(_impl->listenEvent);
+		_impl->listenEvent = WSA_INVALID_EVENT;
+		closesocket(_impl->listening);
+		_impl->listening = INVALID_SOCKET;
+		return 1;
+	}
+
+	std::cout << "Waiting for clients on 0.0.0.0:" << _impl->port << "...\n";
 
+	// Single-threaded event loop over the wake event, the listening socket and
+	// every client socket.
+	std::vector<WSAEVENT> waitSet;
+	waitSet.reserve(WSA_MAXIMUM_WAIT_EVENTS);
+	// From here a tick only reuses buffers sized above; connects, commands and
+	// disconnects are exempted where they happen.
+	allocGuardArmThisThread();
 	while (!_impl->stopping.load(std::memory_order_acquire)) {
-		SOCKET client = accept(_impl->listening, nullptr, nullptr);
-		if (client == INVALID_SOCKET) {
-			if (_impl->stopping.load(std::memory_order_acquire)) break;
-			std::cerr << "Error accepting connection: " << WSAGetLastError() << "\n";
-			continue;
+		waitSet.clear();
+		waitSet.push_back(_impl->wake);
+		waitSet.push_back(_impl->listenEvent);
+		for (const auto& c : _impl->clients) waitSet.push_back(c.ev);
+
+		DWORD r = WSAWaitForMultipleEvents(static_cast<DWORD>(waitSet.size()), waitSet.data(), FALSE, WSA_INFINITE, FALSE);
+		if (r == WSA_WAIT_FAILED) {
+			AllocGuardExempt exempt;
+			std::cerr << "WSAWaitForMultipleEvents failed: " << WSAGetLastError() << "\n";
+			break;
 		}
+		if (_impl->stopping.load(std::memory_order_acquire)) break;
 
-		std::cout << "Client connected.\n";
+		// The wait only reports the lowest signalled index, so every source is
+		// polled each pass to keep later clients from being starved.
+		if (WaitForSingleObject(_impl->wake, 0) == WAIT_OBJECT_0) _impl->handleWake();
+
+		WSANETWORKEVENTS ne{};
+		if (WSAEnumNetworkEvents(_impl->listening, _impl->listenEvent, &ne) == 0 && (ne.lNetworkEvents & FD_ACCEPT)) {
+			_impl->acceptClients();
+		}
 
-		while (!_impl->stopping.load(std::memory_order_acquire)) {
-			try {
-				std::string line = _impl->provider ? _impl->provider() : std::string{};
-				if (line.empty()) {
-					line = "\r\n";
-				} else {
-					if (line.size() < 2 || line.compare(line.size() - 2, 2, "\r\n") != 0) {
-						if (!line.empty() && line.back() == '\n') {
-							// normalize \n -> \r\n
-							if (line.size() < 2 || line[line.size() - 2] != '\r') {
-								line.insert(line.end() - 1, '\r');
-							}
-						} else {
-							line += "\r\n";
-						}
-					}
-				}
-
-				if (!sendAll(client, line.c_str(), static_cast<int>(line.size()))) {
-					int err = WSAGetLastError();
-					// Normal behavior when client disconnects
-					if (err != 0) std::cerr << "Client send failed: " << err << "\n";
-					break;
-				}
-			} catch (const std::exception& e) {
-				std::cerr << "Exception in provider: " << e.what() << "\n";
-				break;
-			} catch (...) {
-				std::cerr << "Unknown exception in provider.\n";
-				break;
+		for (auto& c : _impl->clients) {
+			if (c.dead) continue;
+			ne = WSANETWORKEVENTS{};
+			if (WSAEnumNetworkEvents(c.sock, c.ev, &ne) == SOCKET_ERROR) {
+				c.dead = true;
+				continue;
 			}
-			Sleep(1000);
+			if ((ne.lNetworkEvents & FD_WRITE) && !_impl->flush(c)) continue;
+			if ((ne.lNetworkEvents & FD_READ) && !_impl->readCommands(c)) c.dead = true;
+			if (ne.lNetworkEvents & FD_CLOSE) c.dead = true;
 		}
 
-		shutdown(client, SD_BOTH);
-		closesocket(client);
-		std::cout << "Client disconnected.\n";
+		auto& cl = _impl->clients;
+		for (auto& c : cl) {
+			if (c.dead) _impl->closeClient(c);
+		}
+		cl.erase(std::remove_if(cl.begin(), cl.end(), [](const ClientConn& c) { return c.dead; }), cl.end());
+		_impl->updateSubscribers();
 	}
 
+	allocGuardDisarmThisThread();
+	for (auto& c : _impl->clients) _impl->closeClient(c);
+	_impl->clients.clear();
+	_impl->hasSubscriber.store(false, std::memory_order_release);
+
+	WSAEventSelect(_impl->listening, nullptr, 0);
+	WSACloseEvent(_impl->listenEvent);
+	_impl->listenEvent = WSA_INVALID_EVENT;
+	closesocket(_impl->listening);
+	_impl->listening = INVALID_SOCKET;
 	return 0;
 }
 
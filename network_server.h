@@ -1,24 +1,65 @@
 #pragma once
 
+#include "sys_encode.h"
+
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <string>
 
 namespace sysmon {
 
+// Admission control. Connects and commands are metered per source IPv4
+// address with token buckets; rejected connects are refused inside the
+// accept condition callback, before any per-client state exists.
+struct ServerLimits {
+	std::size_t maxClients{ 8 }; // capped at 62 by the wait-set size
+	double connectsPerSec{ 1.0 };
+	double connectBurst{ 5.0 };
+	double commandsPerSec{ 5.0 };
+	double commandBurst{ 20.0 };
+	std::size_t maxSources{ 256 }; // tracked source addresses
+	// Per-client bytes queued behind a slow reader. A stream line that does
+	// not fit is dropped; a reply or alert that does not fit closes the client.
+	std::size_t maxOutboundBytes{ 64 * 1024 };
+};
+
 class NetworkServer {
 public:
-	using LineProvider = std::function<std::string()>;
+	// Renders the current tick in the requested encoding into `out`, which is
+	// the server's per-encoding buffer and is reused from tick to tick. Called
+	// at most once per tick per encoding, and only for encodings some client
+	// selected.
+	using LineProvider = std::function<void(Encoding, std::string& out)>;
+	// Application-level commands; return false to leave cmd unrecognized.
+	using CommandHandler = std::function<bool(const std::string& cmd, std::string& reply)>;
+	// Appends the "ALERT RAISE" lines of every alert active right now.
+	using AlertReplay = std::function<void(std::string& lines)>;
 
-	NetworkServer(std::uint16_t port, LineProvider provider);
+	NetworkServer(std::uint16_t port, LineProvider provider, const ServerLimits& limits = ServerLimits{});
 	~NetworkServer();
 
 	NetworkServer(const NetworkServer&) = delete;
 	NetworkServer& operator=(const NetworkServer&) = delete;
 
+	// Must be called before run().
+	void setCommandHandler(CommandHandler handler);
+	// Must be called before run(). "SUBSCRIBE ALERT" answers with these lines
+	// after its OK, so a client subscribing mid-incident learns of it at once.
+	// A transition racing the subscription may arrive once more afterwards.
+	void setAlertReplay(AlertReplay replay);
+
 	int run();
 	void stop() noexcept;
 
+	// Thread-safe. Streams one provider line to every connected client; call
+	// it from the sampler's aligned ticks so all clients see the same phase.
+	void notifyTick();
+
+	// Thread-safe. Sends the line right away to clients that issued
+	// "SUBSCRIBE ALERT"; dropped when nobody is subscribed.
+	void pushEvent(const std::string& line);
+
 private:
 	struct Impl;
 	Impl* _impl;
@@ -0,0 +1,46 @@
+#include "sys_adaptive.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sysmon {
+
+AdaptiveRate::AdaptiveRate(const AdaptiveRateConfig& cfg, std::uint32_t initialPeriodMs) : _cfg(cfg) {
+	if (_cfg.minPeriodMs == 0) _cfg.minPeriodMs = 1;
+	if (_cfg.maxPeriodMs < _cfg.minPeriodMs) _cfg.maxPeriodMs = _cfg.minPeriodMs;
+	_periodMs = std::clamp(initialPeriodMs, _cfg.minPeriodMs, _cfg.maxPeriodMs);
+}
+
+double AdaptiveRate::deltaStdDev() const {
+	if (_count < 2) return 0.0;
+	double mean = 0.0;
+	for (std::size_t i = 0; i < _count; ++i) mean += _deltas[i];
+	mean /= static_cast<double>(_count);
+	double var = 0.0;
+	for (std::size_t i = 0; i < _count; ++i) {
+		const double d = _deltas[i] - mean;
+		var += d * d;
+	}
+	return std::sqrt(var / static_cast<double>(_count - 1));
+}
+
+std::uint32_t AdaptiveRate::update(double value, bool nearThreshold) {
+	if (_hasLast) {
+		_deltas[_head] = value - _last;
+		_head = (_head + 1) % kWindow;
+		if (_count < kWindow) ++_count;
+	}
+	_last = value;
+	_hasLast = true;
+
+	const double sd = deltaStdDev();
+	if (nearThreshold || sd >= _cfg.busyStdDev) {
+		_periodMs = std::max(_cfg.minPeriodMs, _periodMs / 2);
+	} else if (_count == kWindow && sd <= _cfg.flatStdDev) {
+		// At least 1 ms, or a 1 ms period would never grow.
+		_periodMs = std::min(_cfg.maxPeriodMs, _periodMs + std::max<std::uint32_t>(1, _periodMs / 2));
+	}
+	return _periodMs;
+}
+
+} // namespace sysmon
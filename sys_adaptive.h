@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sysmon {
+
+struct AdaptiveRateConfig {
+	std::uint32_t minPeriodMs{ 250 };  // ceiling on the sampling rate
+	std::uint32_t maxPeriodMs{ 5000 }; // rate used once the signal is flat
+	double busyStdDev{ 5.0 };          // std-dev of recent deltas (in %) that counts as volatile
+	double flatStdDev{ 0.5 };          // below this the signal counts as flat
+};
+
+// Picks the next sampling period for one collector from the variance of its
+// recent deltas: halve it while the signal is volatile or close to a
+// threshold, stretch it by 1.5x while it stays flat.
+class AdaptiveRate {
+public:
+	AdaptiveRate() = default;
+	AdaptiveRate(const AdaptiveRateConfig& cfg, std::uint32_t initialPeriodMs);
+
+	std::uint32_t update(double value, bool nearThreshold);
+	std::uint32_t periodMs() const { return _periodMs; }
+
+private:
+	static constexpr std::size_t kWindow = 8;
+
+	double deltaStdDev() const;
+
+	AdaptiveRateConfig _cfg;
+	std::uint32_t _periodMs{ 1000 };
+	double _deltas[kWindow]{};
+	std::size_t _count{};
+	std::size_t _head{};
+	double _last{};
+	bool _hasLast{};
+};
+
+} // namespace sysmon
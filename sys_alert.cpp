@@ -0,0 +1,120 @@
+#include "sys_alert.h"
+
+#include <cstdio>
+#include <utility>
+
+namespace sysmon {
+
+static std::size_t singleChannel(const Sample&) { return 1; }
+static std::size_t coreChannels(const Sample& s) { return s.corePercent.size(); }
+
+// Probes skip collectors that did not run this tick so a carried-over value
+// does not advance the sustain count.
+static bool probeCpuTotal(const Sample& s, std::size_t, double& out) {
+	if (!s.cpuFresh || !s.cpuPercent.has) return false;
+	out = s.cpuPercent.value;
+	return true;
+}
+
+static bool probeCpuCore(const Sample& s, std::size_t channel, double& out) {
+	if (!s.cpuFresh || channel >= s.corePercent.size()) return false;
+	out = s.corePercent[channel];
+	return true;
+}
+
+static bool probeMemAvail(const Sample& s, std::size_t, double& out) {
+	if (!s.memFresh || !s.mem.ok || s.mem.totalPhysBytes == 0) return false;
+	out = (static_cast<double>(s.mem.availPhysBytes) * 100.0) / static_cast<double>(s.mem.totalPhysBytes);
+	return true;
+}
+
+std::vector<AlertRule> defaultAlertRules() {
+	std::vector<AlertRule> rules;
+	rules.push_back({ "mem_avail_low", AlertMetric::MemAvailPercent, AlertCompare::Below, 5.0, 7.0, 3 });
+	rules.push_back({ "cpu_core_high", AlertMetric::CpuCorePercent, AlertCompare::Above, 95.0, 85.0, 3 });
+	return rules;
+}
+
+std::string formatAlertLine(const AlertEvent& ev) {
+	char buf[160];
+	const char* name = ev.rule ? ev.rule->name.c_str() : "?";
+	int n = 0;
+	if (ev.channel >= 0) {
+		n = std::snprintf(buf, sizeof(buf), "ALERT %s %s core=%d value=%.1f\r\n", ev.raised ? "RAISE" : "CLEAR", name, ev.channel, ev.value);
+	} else {
+		n = std::snprintf(buf, sizeof(buf), "ALERT %s %s value=%.1f\r\n", ev.raised ? "RAISE" : "CLEAR", name, ev.value);
+	}
+	if (n <= 0) return {};
+	return std::string(buf, static_cast<std::size_t>(n) < sizeof(buf) ? static_cast<std::size_t>(n) : sizeof(buf) - 1);
+}
+
+void AlertEngine::setRules(const std::vector<AlertRule>& rules) {
+	_rules.clear();
+	_rules.reserve(rules.size());
+	for (const auto& r : rules) {
+		CompiledRule c;
+		c.rule = r;
+		if (c.rule.sustainSamples == 0) c.rule.sustainSamples = 1;
+
+		switch (r.metric) {
+		case AlertMetric::CpuTotalPercent:
+			c.channels = singleChannel;
+			c.probe = probeCpuTotal;
+			break;
+		case AlertMetric::CpuCorePercent:
+			c.channels = coreChannels;
+			c.probe = probeCpuCore;
+			c.perChannel = true;
+			break;
+		case AlertMetric::MemAvailPercent:
+			c.channels = singleChannel;
+			c.probe = probeMemAvail;
+			break;
+		default:
+			continue;
+		}
+
+		const bool above = r.compare == AlertCompare::Above;
+		c.trip = { r.threshold, above };
+		// While active, the alert holds as long as the value has not crossed back past clearThreshold.
+		c.hold = { r.clearThreshold, above };
+		_rules.push_back(std::move(c));
+	}
+}
+
+void AlertEngine::evaluate(const Sample& s, std::vector<AlertEvent>& out) {
+	for (auto& c : _rules) {
+		const std::size_t n = c.channels(s);
+		if (c.state.size() != n) c.state.resize(n);
+
+		for (std::size_t ch = 0; ch < n; ++ch) {
+			double v = 0.0;
+			if (!c.probe(s, ch, v)) continue;
+
+			auto& st = c.state[ch];
+			st.value = v;
+			if (!st.active) {
+				st.streak = c.trip(v) ? st.streak + 1 : 0;
+				if (st.streak >= c.rule.sustainSamples) {
+					st.active = true;
+					st.streak = 0;
+					out.push_back({ &c.rule, c.perChannel ? static_cast<int>(ch) : -1, true, v });
+				}
+			} else if (!c.hold(v)) {
+				st.active = false;
+				out.push_back({ &c.rule, c.perChannel ? static_cast<int>(ch) : -1, false, v });
+			}
+		}
+	}
+}
+
+void AlertEngine::active(std::vector<AlertEvent>& out) const {
+	for (const auto& c : _rules) {
+		for (std::size_t ch = 0; ch < c.state.size(); ++ch) {
+			const auto& st = c.state[ch];
+			if (st.active) out.push_back({ &c.rule, c.perChannel ? static_cast<int>(ch) : -1, true, st.value });
+		}
+	}
+}
+
+} // namespace sysmon
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "sys_sample.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sysmon {
+
+enum class AlertMetric {
+	CpuTotalPercent,
+	CpuCorePercent, // evaluated independently for every core
+	MemAvailPercent,
+};
+
+enum class AlertCompare {
+	Above,
+	Below,
+};
+
+struct AlertRule {
+	std::string name;
+	AlertMetric metric{};
+	AlertCompare compare{};
+	double threshold{};
+	// The alert clears only once the value is back on the other side of
+	// clearThreshold; keep it a little below/above threshold for hysteresis.
+	double clearThreshold{};
+	// Consecutive matching samples required before the alert is raised.
+	std::uint32_t sustainSamples{ 1 };
+};
+
+struct AlertEvent {
+	const AlertRule* rule{};
+	int channel{ -1 }; // core index for per-core rules, -1 otherwise
+	bool raised{};
+	double value{};
+};
+
+std::vector<AlertRule> defaultAlertRules();
+
+// "ALERT RAISE <rule> [core=N] value=<v>\r\n"
+std::string formatAlertLine(const AlertEvent& ev);
+
+class AlertEngine {
+public:
+	void setRules(const std::vector<AlertRule>& rules);
+	// Appends state transitions (raise/clear) caused by this sample.
+	void evaluate(const Sample& s, std::vector<AlertEvent>& out);
+	// Appends a raise event for every alert currently active, carrying the
+	// latest value seen; used to bring a new subscriber up to date.
+	void active(std::vector<AlertEvent>& out) const;
+
+private:
+	using ChannelCountFn = std::size_t (*)(const Sample&);
+	using ProbeFn = bool (*)(const Sample&, std::size_t channel, double& out);
+
+	struct Threshold {
+		double value{};
+		bool above{};
+		bool operator()(double v) const { return above ? v > value : v < value; }
+	};
+
+	struct ChannelState {
+		std::uint32_t streak{};
+		bool active{};
+		double value{}; // last probed value
+	};
+
+	struct CompiledRule {
+		AlertRule rule;
+		ChannelCountFn channels{};
+		ProbeFn probe{};
+		Threshold trip;
+		Threshold hold;
+		bool perChannel{};
+		std::vector<ChannelState> state;
+	};
+
+	std::vector<CompiledRule> _rules;
+};
+
+} // namespace sysmon
@@ -0,0 +1,111 @@
+#include "sys_alloc_guard.h"
+
+#include "sys_rss.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace sysmon {
+
+static thread_local bool t_armed = false;
+static std::atomic<std::uint64_t> g_violations{ 0 };
+static std::atomic<std::uint64_t> g_poolMisses{ 0 };
+static std::atomic<bool> g_failFast{ true };
+
+// True when the caller should abort. t_armed stays false without the
+// define, so this never fires there.
+static bool countViolation() noexcept {
+	if (!t_armed) return false;
+	g_violations.fetch_add(1, std::memory_order_relaxed);
+	return g_failFast.load(std::memory_order_relaxed);
+}
+
+#if defined(SYSMON_ALLOC_GUARD)
+
+bool allocGuardEnabled() noexcept {
+	return true;
+}
+
+// Called from operator new, so it must not allocate itself.
+static void onAllocation(std::size_t size) noexcept {
+	if (!countViolation()) return;
+	std::fprintf(stderr, "alloc guard: %zu-byte heap allocation after warm-up\n", size);
+	std::abort();
+}
+
+#else
+
+bool allocGuardEnabled() noexcept {
+	return false;
+}
+
+#endif
+
+void allocGuardArmThisThread() noexcept {
+	t_armed = allocGuardEnabled();
+}
+
+void allocGuardDisarmThisThread() noexcept {
+	t_armed = false;
+}
+
+void allocGuardSetFailFast(bool on) noexcept {
+	g_failFast.store(on, std::memory_order_relaxed);
+}
+
+std::uint64_t allocGuardViolations() noexcept {
+	return g_violations.load(std::memory_order_relaxed);
+}
+
+void allocGuardNotePoolMiss() noexcept {
+	g_poolMisses.fetch_add(1, std::memory_order_relaxed);
+	if (!countViolation()) return;
+	std::fprintf(stderr, "alloc guard: recycle pool exhausted after warm-up\n");
+	std::abort();
+}
+
+std::uint64_t allocGuardPoolMisses() noexcept {
+	return g_poolMisses.load(std::memory_order_relaxed);
+}
+
+AllocGuardExempt::AllocGuardExempt() noexcept : _wasArmed(t_armed) {
+	t_armed = false;
+}
+
+AllocGuardExempt::~AllocGuardExempt() {
+	t_armed = _wasArmed;
+}
+
+std::string formatAllocStats() {
+	char buf[128];
+	std::snprintf(buf, sizeof(buf), "ALLOC guard=%s violations=%llu pool_misses=%llu rss_bytes=%llu\r\n",
+		allocGuardEnabled() ? "on" : "off",
+		static_cast<unsigned long long>(allocGuardViolations()),
+		static_cast<unsigned long long>(allocGuardPoolMisses()),
+		static_cast<unsigned long long>(getProcessRssBytes()));
+	return buf;
+}
+
+} // namespace sysmon
+
+#if defined(SYSMON_ALLOC_GUARD)
+
+// Replacing the plain forms is enough: the array and nothrow forms forward
+// to them.
+void* operator new(std::size_t size) {
+	sysmon::onAllocation(size);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+#endif
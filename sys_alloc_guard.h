@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace sysmon {
+
+// Test hook for the zero-heap steady state. Built with SYSMON_ALLOC_GUARD,
+// global operator new reports every allocation made on a thread that armed
+// the guard after its warm-up, and aborts on the first one unless fail-fast
+// was turned off. Without the define all of these are no-ops and
+// allocGuardEnabled() is false.
+bool allocGuardEnabled() noexcept;
+void allocGuardArmThisThread() noexcept;
+void allocGuardDisarmThisThread() noexcept;
+void allocGuardSetFailFast(bool on) noexcept;
+std::uint64_t allocGuardViolations() noexcept;
+
+// Called by RecyclePool when every slot is busy and acquire() falls back to
+// the heap. Counted in every build; on an armed thread it is also a
+// violation, since the exempt fallback would otherwise hide it.
+void allocGuardNotePoolMiss() noexcept;
+std::uint64_t allocGuardPoolMisses() noexcept;
+
+// Suspends the guard on this thread for paths that are allowed to allocate:
+// client commands, connects and alert transitions, none of which run per tick.
+class AllocGuardExempt {
+public:
+	AllocGuardExempt() noexcept;
+	~AllocGuardExempt();
+
+	AllocGuardExempt(const AllocGuardExempt&) = delete;
+	AllocGuardExempt& operator=(const AllocGuardExempt&) = delete;
+
+private:
+	bool _wasArmed;
+};
+
+// "ALLOC guard=on|off violations=N pool_misses=N rss_bytes=N" for the
+// STATS ALLOC command.
+std::string formatAllocStats();
+
+} // namespace sysmon
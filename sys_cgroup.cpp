@@ -0,0 +1,355 @@
+#include "sys_cgroup.h"
+
+#include "sys_alloc_guard.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <unordered_map>
+#endif
+
+namespace sysmon {
+
+#if defined(__linux__)
+
+// Bounds the number of tracked groups (and so of open fds, four per group).
+static constexpr std::size_t kMaxCgroups = 1024;
+
+struct CgroupFiles {
+	std::string path;
+	int cpuStat{ -1 };
+	int memCurrent{ -1 };
+	int memMax{ -1 };
+	int ioStat{ -1 };
+	int wd{ -1 };
+	std::uint64_t prevUsageUsec{};
+	bool hasPrev{};
+};
+
+struct CgroupMonitor::Impl {
+	std::string mount;
+	int inotifyFd{ -1 };
+	std::unordered_map<std::string, CgroupFiles> groups; // keyed by relative path
+	std::unordered_map<int, std::string> watches;        // wd -> relative path
+	std::uint64_t prevUs{};
+	char buf[4096];
+
+	void addTree(const std::string& rel);
+	bool addGroup(const std::string& rel);
+	void removeTree(const std::string& rel);
+	void drainEvents();
+};
+
+static std::uint64_t monotonicUs() {
+	timespec ts{};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<std::uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<std::uint64_t>(ts.tv_nsec) / 1000ULL;
+}
+
+static void closeFd(int& fd) {
+	if (fd >= 0) close(fd);
+	fd = -1;
+}
+
+static std::string joinPath(const std::string& rel, const char* name) {
+	return rel == "/" ? "/" + std::string(name) : rel + "/" + name;
+}
+
+bool CgroupMonitor::Impl::addGroup(const std::string& rel) {
+	if (groups.count(rel)) return true;
+	if (groups.size() >= kMaxCgroups) return false;
+
+	const std::string dir = rel == "/" ? mount : mount + rel;
+	CgroupFiles g;
+	g.path = rel;
+	g.cpuStat = open((dir + "/cpu.stat").c_str(), O_RDONLY | O_CLOEXEC);
+	if (g.cpuStat < 0) return false; // not a cgroup v2 directory
+	// The root has no memory.current / memory.max; those stay -1.
+	g.memCurrent = open((dir + "/memory.current").c_str(), O_RDONLY | O_CLOEXEC);
+	g.memMax = open((dir + "/memory.max").c_str(), O_RDONLY | O_CLOEXEC);
+	g.ioStat = open((dir + "/io.stat").c_str(), O_RDONLY | O_CLOEXEC);
+	g.wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+	if (g.wd >= 0) watches[g.wd] = rel;
+	groups.emplace(rel, std::move(g));
+	return true;
+}
+
+// Watch first, then list, so a child created in between is seen either by
+// the listing or by an IN_CREATE event (addGroup ignores duplicates).
+void CgroupMonitor::Impl::addTree(const std::string& rel) {
+	if (!addGroup(rel)) return;
+
+	const std::string dir = rel == "/" ? mount : mount + rel;
+	DIR* d = opendir(dir.c_str());
+	if (!d) return;
+	while (dirent* e = readdir(d)) {
+		if (e->d_type != DT_DIR) continue;
+		if (std::strcmp(e->d_name, ".") == 0 || std::strcmp(e->d_name, "..") == 0) continue;
+		addTree(joinPath(rel, e->d_name));
+	}
+	closedir(d);
+}
+
+void CgroupMonitor::Impl::removeTree(const std::string& rel) {
+	const std::string prefix = rel == "/" ? "/" : rel + "/";
+	for (auto it = groups.begin(); it != groups.end();) {
+		if (it->first != rel && it->first.compare(0, prefix.size(), prefix) != 0) {
+			++it;
+			continue;
+		}
+		CgroupFiles& g = it->second;
+		closeFd(g.cpuStat);
+		closeFd(g.memCurrent);
+		closeFd(g.memMax);
+		closeFd(g.ioStat);
+		if (g.wd >= 0) {
+			inotify_rm_watch(inotifyFd, g.wd);
+			watches.erase(g.wd);
+		}
+		it = groups.erase(it);
+	}
+}
+
+void CgroupMonitor::Impl::drainEvents() {
+	alignas(inotify_event) char events[4096];
+	for (;;) {
+		const ssize_t n = read(inotifyFd, events, sizeof(events));
+		if (n <= 0) break;
+		// A cgroup coming or going is an event, not per-tick work.
+		AllocGuardExempt exempt;
+		for (ssize_t off = 0; off < n;) {
+			const auto* ev = reinterpret_cast<const inotify_event*>(events + off);
+			off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+			if (!(ev->mask & IN_ISDIR) || ev->len == 0) continue;
+
+			auto w = watches.find(ev->wd);
+			if (w == watches.end()) continue;
+			const std::string child = joinPath(w->second, ev->name);
+			if (ev->mask & (IN_CREATE | IN_MOVED_TO)) addTree(child);
+			if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) removeTree(child);
+		}
+	}
+}
+
+static ssize_t readAt0(int fd, char* buf, std::size_t cap) {
+	if (fd < 0) return -1;
+	const ssize_t n = pread(fd, buf, cap - 1, 0);
+	if (n >= 0) buf[n] = '\0';
+	return n;
+}
+
+// Value following "<key> " at the start of a line.
+static bool findKey(const char* text, const char* key, std::uint64_t& out) {
+	const std::size_t klen = std::strlen(key);
+	for (const char* p = text; p && *p;) {
+		if (std::strncmp(p, key, klen) == 0 && p[klen] == ' ') {
+			out = std::strtoull(p + klen + 1, nullptr, 10);
+			return true;
+		}
+		p = std::strchr(p, '\n');
+		if (p) ++p;
+	}
+	return false;
+}
+
+// io.stat: "<maj>:<min> rbytes=N wbytes=N rios=N ..." per device; summed.
+static void sumIoStat(const char* text, std::uint64_t& rbytes, std::uint64_t& wbytes) {
+	rbytes = wbytes = 0;
+	for (const char* p = text; (p = std::strstr(p, "bytes=")) != nullptr; p += 6) {
+		if (p == text) continue;
+		const char kind = p[-1];
+		const std::uint64_t v = std::strtoull(p + 6, nullptr, 10);
+		if (kind == 'r') rbytes += v;
+		else if (kind == 'w') wbytes += v;
+	}
+}
+
+// procfs files report a size of 0, so this reads until EOF.
+static std::string readMountinfo() {
+	std::string text;
+	const int fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return text;
+	char chunk[4096];
+	ssize_t n;
+	while ((n = read(fd, chunk, sizeof(chunk))) > 0) text.append(chunk, static_cast<std::size_t>(n));
+	close(fd);
+	return text;
+}
+
+CgroupMonitor::CgroupMonitor() : _impl(new Impl{}) {}
+
+CgroupMonitor::~CgroupMonitor() {
+	if (!_impl) return;
+	_impl->removeTree("/");
+	closeFd(_impl->inotifyFd);
+	delete _impl;
+	_impl = nullptr;
+}
+
+bool CgroupMonitor::init(const char* mountPoint) {
+	if (!_impl || _impl->inotifyFd >= 0) return _impl && _impl->inotifyFd >= 0;
+
+	if (mountPoint) {
+		_impl->mount = mountPoint;
+	} else {
+		_impl->mount = findCgroup2Mount(readMountinfo().c_str());
+		if (_impl->mount.empty()) return false;
+	}
+	if (access((_impl->mount + "/cgroup.controllers").c_str(), F_OK) != 0) return false;
+
+	_impl->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_impl->inotifyFd < 0) return false;
+
+	_impl->addTree("/");
+	_impl->prevUs = monotonicUs();
+	return !_impl->groups.empty();
+}
+
+// Entries are overwritten in place, so when `out` is a recycled vector of
+// the same size the path strings keep their capacity and nothing allocates.
+bool CgroupMonitor::sample(std::vector<CgroupUsage>& out) {
+	if (!_impl || _impl->inotifyFd < 0) {
+		out.clear();
+		return false;
+	}
+
+	_impl->drainEvents();
+
+	const std::uint64_t nowUs = monotonicUs();
+	const std::uint64_t elapsedUs = nowUs > _impl->prevUs ? nowUs - _impl->prevUs : 0;
+	_impl->prevUs = nowUs;
+
+	// The list only grows (and paths only lengthen) after the hierarchy changed.
+	if (out.size() != _impl->groups.size()) {
+		AllocGuardExempt exempt;
+		out.resize(_impl->groups.size());
+	}
+	char* buf = _impl->buf;
+	const std::size_t cap = sizeof(_impl->buf);
+	std::size_t idx = 0;
+	for (auto& kv : _impl->groups) {
+		CgroupFiles& g = kv.second;
+		CgroupUsage& u = out[idx++];
+		if (u.path.capacity() < g.path.size()) {
+			AllocGuardExempt exempt;
+			u.path = g.path;
+		} else {
+			u.path = g.path;
+		}
+		u.cpuUsageUsec = 0;
+		u.cpuPercent = 0.0;
+		u.memCurrentBytes = 0;
+		u.memMaxBytes = 0;
+
+		if (readAt0(g.cpuStat, buf, cap) > 0 && findKey(buf, "usage_usec", u.cpuUsageUsec)) {
+			if (g.hasPrev && elapsedUs && u.cpuUsageUsec >= g.prevUsageUsec) {
+				u.cpuPercent = static_cast<double>(u.cpuUsageUsec - g.prevUsageUsec) * 100.0 / static_cast<double>(elapsedUs);
+			}
+			g.prevUsageUsec = u.cpuUsageUsec;
+			g.hasPrev = true;
+		}
+		if (readAt0(g.memCurrent, buf, cap) > 0) u.memCurrentBytes = std::strtoull(buf, nullptr, 10);
+		if (readAt0(g.memMax, buf, cap) > 0 && std::strncmp(buf, "max", 3) != 0) u.memMaxBytes = std::strtoull(buf, nullptr, 10);
+		sumIoStat(readAt0(g.ioStat, buf, cap) >= 0 ? buf : "", u.ioReadBytes, u.ioWriteBytes);
+	}
+	return true;
+}
+
+#else
+
+struct CgroupMonitor::Impl {};
+
+CgroupMonitor::CgroupMonitor() : _impl(nullptr) {}
+CgroupMonitor::~CgroupMonitor() = default;
+
+bool CgroupMonitor::init(const char*) {
+	return false;
+}
+
+bool CgroupMonitor::sample(std::vector<CgroupUsage>& out) {
+	out.clear();
+	return false;
+}
+
+#endif
+
+static bool isOctal(char c) {
+	return c >= '0' && c <= '7';
+}
+
+// Decodes the \ooo escapes mountinfo uses for space, tab, newline and '\\'.
+static std::string unescapeMountField(const char* p, std::size_t len) {
+	std::string out;
+	for (std::size_t i = 0; i < len; ++i) {
+		if (p[i] == '\\' && i + 3 < len && isOctal(p[i + 1]) && isOctal(p[i + 2]) && isOctal(p[i + 3])) {
+			out += static_cast<char>(((p[i + 1] - '0') << 6) | ((p[i + 2] - '0') << 3) | (p[i + 3] - '0'));
+			i += 3;
+		} else {
+			out += p[i];
+		}
+	}
+	return out;
+}
+
+// "<id> <parent> <maj:min> <root> <mount point> <options> [optional...] - <fstype> <source> <super options>"
+std::string findCgroup2Mount(const char* mountinfo) {
+	for (const char* line = mountinfo; line && *line;) {
+		const char* end = std::strchr(line, '\n');
+		const std::size_t len = end ? static_cast<std::size_t>(end - line) : std::strlen(line);
+		const std::string l(line, len);
+		line = end ? end + 1 : nullptr;
+
+		const std::size_t sep = l.find(" - ");
+		if (sep == std::string::npos || l.compare(sep + 3, 8, "cgroup2 ") != 0) continue;
+		// The mount point is the fifth space-separated field.
+		std::size_t start = 0;
+		for (int field = 0; field < 4 && start != std::string::npos; ++field) {
+			start = l.find(' ', start);
+			if (start != std::string::npos) ++start;
+		}
+		if (start == std::string::npos || start >= sep) continue;
+		const std::size_t stop = l.find(' ', start);
+		return unescapeMountField(l.data() + start, stop - start);
+	}
+	return std::string();
+}
+
+void topCgroups(std::vector<CgroupUsage>& groups, CgroupSort by, std::size_t n) {
+	auto heavier = [by](const CgroupUsage& a, const CgroupUsage& b) {
+		return by == CgroupSort::Cpu ? a.cpuPercent > b.cpuPercent : a.memCurrentBytes > b.memCurrentBytes;
+	};
+	n = std::min(n, groups.size());
+	std::partial_sort(groups.begin(), groups.begin() + static_cast<std::ptrdiff_t>(n), groups.end(), heavier);
+	groups.resize(n);
+}
+
+std::string formatCgroupTop(std::vector<CgroupUsage> groups, CgroupSort by, std::size_t n) {
+	topCgroups(groups, by, n);
+	std::string out;
+	char buf[160];
+	for (const auto& g : groups) {
+		std::snprintf(buf, sizeof(buf), " cpu=%.1f mem=%llu mem_max=%llu io_r=%llu io_w=%llu\r\n",
+			g.cpuPercent,
+			static_cast<unsigned long long>(g.memCurrentBytes),
+			static_cast<unsigned long long>(g.memMaxBytes),
+			static_cast<unsigned long long>(g.ioReadBytes),
+			static_cast<unsigned long long>(g.ioWriteBytes));
+		out += "CGROUP ";
+		out += g.path;
+		out += buf;
+	}
+	if (out.empty()) out = "CGROUP none\r\n";
+	return out;
+}
+
+} // namespace sysmon
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sysmon {
+
+// Per-cgroup usage from the cgroup v2 hierarchy. Only Linux has cgroups; on
+// Windows CgroupMonitor::init() fails and Sample::cgroups stays empty.
+struct CgroupUsage {
+	std::string path; // relative to the cgroup2 mount, "/" for the root
+	std::uint64_t cpuUsageUsec{}; // cumulative, from cpu.stat
+	double cpuPercent{};          // of one CPU since the previous sample
+	std::uint64_t memCurrentBytes{};
+	std::uint64_t memMaxBytes{}; // 0 when unlimited ("max")
+	std::uint64_t ioReadBytes{};
+	std::uint64_t ioWriteBytes{};
+};
+
+enum class CgroupSort {
+	Cpu,
+	Memory,
+};
+
+// Walks the hierarchy once in init(), keeps cpu.stat / memory.current /
+// memory.max / io.stat open per cgroup and re-reads them with pread() on
+// every sample. Cgroups created or removed later are picked up from inotify
+// instead of rescanning the tree.
+class CgroupMonitor {
+public:
+	CgroupMonitor();
+	~CgroupMonitor();
+
+	CgroupMonitor(const CgroupMonitor&) = delete;
+	CgroupMonitor& operator=(const CgroupMonitor&) = delete;
+
+	// Without a mount point, the cgroup2 mount is looked up in
+	// /proc/self/mountinfo (hybrid hosts mount it at /sys/fs/cgroup/unified).
+	bool init(const char* mountPoint = nullptr);
+	bool sample(std::vector<CgroupUsage>& out);
+
+private:
+	struct Impl;
+	Impl* _impl;
+};
+
+// Mount point of the first cgroup2 filesystem in a /proc/<pid>/mountinfo
+// text, with its octal escapes decoded; empty when there is none.
+std::string findCgroup2Mount(const char* mountinfo);
+
+// Keeps the n heaviest entries, ordered heaviest first.
+void topCgroups(std::vector<CgroupUsage>& groups, CgroupSort by, std::size_t n);
+
+// "CGROUP <path> cpu=<pct> mem=<bytes> ..." lines, one per entry.
+std::string formatCgroupTop(std::vector<CgroupUsage> groups, CgroupSort by, std::size_t n);
+
+} // namespace sysmon
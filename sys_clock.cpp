@@ -0,0 +1,70 @@
+#include "sys_clock.h"
+
+#include <windows.h>
+
+#include <cstdio>
+
+namespace sysmon {
+
+// 100 ns ticks between 1601-01-01 (FILETIME) and 1970-01-01 (Unix).
+static constexpr std::uint64_t kFileTimeToUnixTicks = 116444736000000000ULL;
+
+std::uint64_t monotonicNs() {
+	static const std::uint64_t freq = []() {
+		LARGE_INTEGER f{};
+		QueryPerformanceFrequency(&f);
+		return static_cast<std::uint64_t>(f.QuadPart);
+	}();
+	LARGE_INTEGER c{};
+	QueryPerformanceCounter(&c);
+	const std::uint64_t ticks = static_cast<std::uint64_t>(c.QuadPart);
+	// Split to avoid overflowing ticks * 1e9.
+	return (ticks / freq) * 1000000000ULL + ((ticks % freq) * 1000000000ULL) / freq;
+}
+
+std::uint64_t wallClockNs() {
+	FILETIME ft{};
+	GetSystemTimePreciseAsFileTime(&ft);
+	ULARGE_INTEGER u{};
+	u.LowPart = ft.dwLowDateTime;
+	u.HighPart = ft.dwHighDateTime;
+	return (static_cast<std::uint64_t>(u.QuadPart) - kFileTimeToUnixTicks) * 100ULL;
+}
+
+void JitterHistogram::record(std::uint64_t latenessNs) {
+	std::uint64_t us = latenessNs / 1000;
+	std::size_t bucket = 0;
+	while (us && bucket < kBuckets - 1) {
+		us >>= 1;
+		++bucket;
+	}
+	_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+
+	std::uint64_t prev = _maxNs.load(std::memory_order_relaxed);
+	while (latenessNs > prev && !_maxNs.compare_exchange_weak(prev, latenessNs, std::memory_order_relaxed)) {
+	}
+}
+
+std::string JitterHistogram::format() const {
+	std::uint64_t counts[kBuckets];
+	std::size_t used = 0;
+	for (std::size_t i = 0; i < kBuckets; ++i) {
+		counts[i] = _buckets[i].load(std::memory_order_relaxed);
+		if (counts[i]) used = i + 1;
+	}
+
+	char buf[64];
+	std::snprintf(buf, sizeof(buf), "JITTER count=%llu max_us=%llu",
+		static_cast<unsigned long long>(_count.load(std::memory_order_relaxed)),
+		static_cast<unsigned long long>(_maxNs.load(std::memory_order_relaxed) / 1000));
+	std::string out = buf;
+	for (std::size_t i = 0; i < used; ++i) {
+		std::snprintf(buf, sizeof(buf), " b%zu=%llu", i, static_cast<unsigned long long>(counts[i]));
+		out += buf;
+	}
+	out += "\r\n";
+	return out;
+}
+
+} // namespace sysmon
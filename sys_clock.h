@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sysmon {
+
+// QueryPerformanceCounter scaled to nanoseconds; only meaningful as a difference.
+std::uint64_t monotonicNs();
+// GetSystemTimePreciseAsFileTime as nanoseconds since the Unix epoch.
+std::uint64_t wallClockNs();
+
+// Lateness of scheduled wake-ups in power-of-two microsecond buckets:
+// bucket 0 is < 1 us, bucket i is [2^(i-1), 2^i) us, the last one is open.
+class JitterHistogram {
+public:
+	static constexpr std::size_t kBuckets = 24;
+
+	void record(std::uint64_t latenessNs);
+	// "JITTER count=<n> max_us=<m> b0=<c0> b1=<c1> ..." (trailing empty buckets omitted)
+	std::string format() const;
+
+private:
+	std::atomic<std::uint64_t> _buckets[kBuckets]{};
+	std::atomic<std::uint64_t> _count{};
+	std::atomic<std::uint64_t> _maxNs{};
+};
+
+} // namespace sysmon
@@ -0,0 +1,279 @@
+#pragma once
+
+#include "sys_sample.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace sysmon {
+
+// Compile-time collector selection. A build names the collectors it wants
+// as a CollectorSet; code for the others is never instantiated, so with
+// /OPT:REF their functions and DLL imports (DXGI, IP Helper, PDH) are
+// dropped from the binary, and the sampler never spends startup time
+// opening their queries. The same set generates the fixed binary wire
+// layout (WireLayout below): every field sits at a constant offset and the
+// frame size is a compile-time constant.
+//
+// Each tag describes one collector:
+//   kName      schema name, as reported by the SCHEMA command
+//   kBit       bit in the frame's collector mask; unique per tag
+//   kWireBytes size of its fixed record (0 for identity-only collectors,
+//              whose strings are carried in the device report instead)
+//   pack()     writes the record from a Sample; no allocation, no dispatch
+namespace collect {
+
+namespace wire {
+
+inline void putU16(unsigned char* p, std::uint16_t v) {
+	p[0] = static_cast<unsigned char>(v);
+	p[1] = static_cast<unsigned char>(v >> 8);
+}
+
+inline void putU32(unsigned char* p, std::uint32_t v) {
+	for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+inline void putU64(unsigned char* p, std::uint64_t v) {
+	for (int i = 0; i < 8; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+// IEEE-754 double, little-endian; unavailable values are NaN.
+inline void putF64(unsigned char* p, double v) {
+	static_assert(sizeof(double) == sizeof(std::uint64_t), "64-bit double expected");
+	std::uint64_t bits;
+	std::memcpy(&bits, &v, sizeof(bits));
+	putU64(p, bits);
+}
+
+inline double orNaN(const OptDbl& v) {
+	return v.has ? v.value : std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace wire
+
+struct Cpu {
+	static constexpr const char* kName = "cpu";
+	static constexpr unsigned kBit = 0;
+	// f64 cpu_pct, u32 period_ms, u16 cores, u8 fresh, u8 pad
+	static constexpr std::size_t kWireBytes = 16;
+	static void pack(const Sample& s, unsigned char* p) {
+		wire::putF64(p, wire::orNaN(s.cpuPercent));
+		wire::putU32(p + 8, s.cpuPeriodMs);
+		wire::putU16(p + 12, static_cast<std::uint16_t>(s.corePercent.size()));
+		p[14] = s.cpuFresh;
+		p[15] = 0;
+	}
+};
+
+struct Mem {
+	static constexpr const char* kName = "mem";
+	static constexpr unsigned kBit = 1;
+	// u64 total_bytes, u64 avail_bytes, u32 period_ms, u8 ok, u8 fresh, u16 pad
+	static constexpr std::size_t kWireBytes = 24;
+	static void pack(const Sample& s, unsigned char* p) {
+		wire::putU64(p, s.mem.totalPhysBytes);
+		wire::putU64(p + 8, s.mem.availPhysBytes);
+		wire::putU32(p + 16, s.memPeriodMs);
+		p[20] = s.mem.ok;
+		p[21] = s.memFresh;
+		wire::putU16(p + 22, 0);
+	}
+};
+
+struct MemPressure {
+	static constexpr const char* kName = "mem_pressure";
+	static constexpr unsigned kBit = 2;
+	// u64 commit, commit_limit, system_cache, standby, modified;
+	// f64 page_faults_per_sec, hard_faults_per_sec; u8 ok, u8 have_lists, 6 pad
+	static constexpr std::size_t kWireBytes = 64;
+	static void pack(const Sample& s, unsigned char* p) {
+		const sysmon::MemPressure& mp = s.memPressure;
+		wire::putU64(p, mp.commitBytes);
+		wire::putU64(p + 8, mp.commitLimitBytes);
+		wire::putU64(p + 16, mp.systemCacheBytes);
+		wire::putU64(p + 24, mp.standbyBytes);
+		wire::putU64(p + 32, mp.modifiedBytes);
+		wire::putF64(p + 40, wire::orNaN(mp.pageFaultsPerSec));
+		wire::putF64(p + 48, wire::orNaN(mp.hardFaultsPerSec));
+		p[56] = mp.ok;
+		p[57] = mp.haveLists;
+		for (int i = 58; i < 64; ++i) p[i] = 0;
+	}
+};
+
+// Per-core MHz and thermal zones vary in count, so the fixed record carries
+// the aggregates; the full arrays stay in the ndjson encoding.
+struct Freq {
+	static constexpr const char* kName = "freq";
+	static constexpr unsigned kBit = 3;
+	// f64 perf_limit_pct, f64 hottest_c, u32 avg_mhz, u32 max_mhz,
+	// u8 throttled, u8 ok, u8 fresh, 5 pad
+	static constexpr std::size_t kWireBytes = 32;
+	static void pack(const Sample& s, unsigned char* p) {
+		const CpuFreqInfo& f = s.freq;
+		double hottest = std::numeric_limits<double>::quiet_NaN();
+		for (double c : f.thermalZonesC) {
+			if (std::isnan(hottest) || c > hottest) hottest = c;
+		}
+		std::uint64_t sumMhz = 0;
+		std::uint32_t maxMhz = 0;
+		for (const CoreFreq& c : f.cores) {
+			sumMhz += c.currentMhz;
+			if (c.maxMhz > maxMhz) maxMhz = c.maxMhz;
+		}
+		const std::uint32_t avgMhz = f.cores.empty() ? 0 : static_cast<std::uint32_t>(sumMhz / f.cores.size());
+		wire::putF64(p, wire::orNaN(f.perfLimitPercent));
+		wire::putF64(p + 8, hottest);
+		wire::putU32(p + 16, avgMhz);
+		wire::putU32(p + 20, maxMhz);
+		p[24] = f.throttled;
+		p[25] = f.ok;
+		p[26] = s.freqFresh;
+		for (int i = 27; i < 32; ++i) p[i] = 0;
+	}
+};
+
+// The busiest group only; TOP CGROUPS and ndjson carry the list.
+struct Cgroup {
+	static constexpr const char* kName = "cgroup";
+	static constexpr unsigned kBit = 4;
+	// f64 busiest_cpu_pct, u32 groups, u8 fresh, 3 pad
+	static constexpr std::size_t kWireBytes = 16;
+	static void pack(const Sample& s, unsigned char* p) {
+		double busiest = std::numeric_limits<double>::quiet_NaN();
+		std::uint32_t count = 0;
+		if (s.cgroups) {
+			count = static_cast<std::uint32_t>(s.cgroups->size());
+			for (const CgroupUsage& g : *s.cgroups) {
+				if (std::isnan(busiest) || g.cpuPercent > busiest) busiest = g.cpuPercent;
+			}
+		}
+		wire::putF64(p, busiest);
+		wire::putU32(p + 8, count);
+		p[12] = s.cgroupFresh;
+		p[13] = p[14] = p[15] = 0;
+	}
+};
+
+// Identity-only collectors: MAC/IP (IP Helper) and the GPU adapter name
+// (DXGI). They add lines to the device report, not fields to the frame.
+struct Network {
+	static constexpr const char* kName = "network";
+	static constexpr unsigned kBit = 5;
+	static constexpr std::size_t kWireBytes = 0;
+	static void pack(const Sample&, unsigned char*) {}
+};
+
+struct Gpu {
+	static constexpr const char* kName = "gpu";
+	static constexpr unsigned kBit = 6;
+	static constexpr std::size_t kWireBytes = 0;
+	static void pack(const Sample&, unsigned char*) {}
+};
+
+constexpr std::size_t bitCount(std::uint32_t m) {
+	std::size_t n = 0;
+	for (; m; m &= m - 1) ++n;
+	return n;
+}
+
+} // namespace collect
+
+template <class... Cs>
+struct CollectorSet {
+	template <class C>
+	static constexpr bool has = (std::is_same_v<C, Cs> || ...);
+
+	static constexpr std::uint32_t kMask = (0u | ... | (1u << Cs::kBit));
+	static constexpr std::size_t kCount = sizeof...(Cs);
+	static_assert(collect::bitCount(kMask) == kCount, "a collector is listed twice (or two tags share a bit)");
+};
+
+// Binary frame: a 32-byte header followed by each collector's record, in the
+// order the set lists them. All integers are little-endian.
+//   0  "SM"       4  u16 frame bytes   8  u64 seq
+//   2  u8 version 6  u16 reserved     16  u64 mono_ns
+//   3  u8 mask                        24  u64 wall_ns
+template <class Set>
+struct WireLayout;
+
+template <class... Cs>
+struct WireLayout<CollectorSet<Cs...>> {
+	using Set = CollectorSet<Cs...>;
+
+	static constexpr std::uint8_t kVersion = 1;
+	static constexpr std::size_t kHeaderBytes = 32;
+	static constexpr std::size_t kSize = kHeaderBytes + (std::size_t{ 0 } + ... + Cs::kWireBytes);
+	static_assert(kSize <= 0xFFFF, "frame size must fit the u16 header field");
+	static_assert(Set::kMask <= 0xFF, "collector mask must fit the u8 header field");
+
+	template <class C>
+	static constexpr std::size_t offsetOf() {
+		static_assert(Set::template has<C>, "collector is not part of this layout");
+		std::size_t off = kHeaderBytes;
+		bool found = false;
+		((found = found || std::is_same_v<C, Cs>, off += found ? 0 : Cs::kWireBytes), ...);
+		return off;
+	}
+
+	// Writes exactly kSize bytes.
+	static void encode(const Sample& s, unsigned char* out) {
+		out[0] = 'S';
+		out[1] = 'M';
+		out[2] = kVersion;
+		out[3] = static_cast<unsigned char>(Set::kMask);
+		collect::wire::putU16(out + 4, static_cast<std::uint16_t>(kSize));
+		collect::wire::putU16(out + 6, 0);
+		collect::wire::putU64(out + 8, s.seq);
+		collect::wire::putU64(out + 16, s.monoNs);
+		collect::wire::putU64(out + 24, s.wallNs);
+		(Cs::pack(s, out + offsetOf<Cs>()), ...);
+	}
+
+	// "SCHEMA v1 bytes=N cpu@32+16 mem@48+24 ...": what a client needs to
+	// decode the frame. Identity-only collectors are listed with +0.
+	static std::string describe() {
+		std::string out = "SCHEMA v" + std::to_string(kVersion) + " bytes=" + std::to_string(kSize);
+		((out += ' ', out += Cs::kName, out += '@', out += std::to_string(offsetOf<Cs>()), out += '+', out += std::to_string(Cs::kWireBytes)), ...);
+		return out;
+	}
+};
+
+// The collectors this binary is built with. Define SYSMON_MINIMAL for a
+// CPU + RAM build, or SYSMON_COLLECTORS to a comma-separated list of tags
+// (e.g. collect::Cpu,collect::Mem,collect::Freq) for any other mix.
+#if defined(SYSMON_COLLECTORS)
+using BuildCollectors = CollectorSet<SYSMON_COLLECTORS>;
+#elif defined(SYSMON_MINIMAL)
+using BuildCollectors = CollectorSet<collect::Cpu, collect::Mem>;
+#else
+using BuildCollectors = CollectorSet<collect::Cpu, collect::Mem, collect::MemPressure, collect::Freq,
+	collect::Cgroup, collect::Network, collect::Gpu>;
+#endif
+
+using BuildWireLayout = WireLayout<BuildCollectors>;
+
+template <class C>
+constexpr bool kBuiltWith = BuildCollectors::has<C>;
+
+// Stand-in for the state of a collector the build leaves out.
+struct NotBuilt {};
+
+template <class C, class T>
+using BuiltState = std::conditional_t<kBuiltWith<C>, T, NotBuilt>;
+
+// Calls f(state) only when the build includes any of the collectors C.
+// Pass a generic lambda: for left-out collectors its body is never
+// instantiated, so nothing it calls gets referenced.
+template <class... C, class State, class F>
+inline void ifBuiltWith(State& state, F&& f) {
+	if constexpr ((kBuiltWith<C> || ...)) f(state);
+}
+
+} // namespace sysmon
@@ -1,6 +1,7 @@
 #include "sys_cpu.h"
 
 #include <windows.h>
+#include <winternl.h>
 
 namespace sysmon {
 
@@ -31,11 +32,47 @@ static bool calcCpuUsagePercent(const CpuTimesSample& prev, const CpuTimesSample
 	return true;
 }
 
+using NtQuerySystemInformationFn = LONG(WINAPI*)(SYSTEM_INFORMATION_CLASS, PVOID, ULONG, PULONG);
+
+static NtQuerySystemInformationFn resolveNtQuerySystemInformation() {
+	static const NtQuerySystemInformationFn fn = []() -> NtQuerySystemInformationFn {
+		HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+		if (!ntdll) return nullptr;
+		return reinterpret_cast<NtQuerySystemInformationFn>(GetProcAddress(ntdll, "NtQuerySystemInformation"));
+	}();
+	return fn;
+}
+
+static bool sampleCoreTimes(std::vector<unsigned char>& buf, std::vector<CpuTimesSample>& out) {
+	auto query = resolveNtQuerySystemInformation();
+	if (!query) return false;
+
+	SYSTEM_INFO si{};
+	GetSystemInfo(&si);
+	if (si.dwNumberOfProcessors == 0) return false;
+
+	const size_t bytes = si.dwNumberOfProcessors * sizeof(SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION);
+	if (buf.size() < bytes) buf.resize(bytes);
+	auto* info = reinterpret_cast<SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION*>(buf.data());
+	ULONG returned = 0;
+	if (query(SystemProcessorPerformanceInformation, info, static_cast<ULONG>(bytes), &returned) < 0) return false;
+
+	const size_t count = returned / sizeof(info[0]);
+	out.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		out[i].idle = static_cast<std::uint64_t>(info[i].IdleTime.QuadPart);
+		out[i].kernel = static_cast<std::uint64_t>(info[i].KernelTime.QuadPart);
+		out[i].user = static_cast<std::uint64_t>(info[i].UserTime.QuadPart);
+	}
+	return count > 0;
+}
+
 bool CpuMonitor::init() {
 	CpuTimesSample s;
 	if (!sampleCpuTimes(s)) return false;
 	_prev = s;
 	_hasPrev = true;
+	sampleCoreTimes(_queryBuf, _prevCores);
 	return true;
 }
 
@@ -49,4 +86,21 @@ bool CpuMonitor::getCpuPercent(double& outPercent) {
 	return ok;
 }
 
+bool CpuMonitor::getCorePercents(std::vector<double>& outPercents) {
+	std::vector<CpuTimesSample>& cur = _curCores;
+	if (!sampleCoreTimes(_queryBuf, cur)) return false;
+	bool ok = false;
+	if (_prevCores.size() == cur.size()) {
+		outPercents.resize(cur.size());
+		ok = true;
+		for (size_t i = 0; i < cur.size(); ++i) {
+			// An idle core with no elapsed ticks simply reads as 0%.
+			outPercents[i] = 0.0;
+			calcCpuUsagePercent(_prevCores[i], cur[i], outPercents[i]);
+		}
+	}
+	_prevCores.swap(cur);
+	return ok;
+}
+
 } // namespace sysmon
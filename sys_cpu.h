@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <vector>
 
 namespace sysmon {
 
@@ -18,10 +19,16 @@ class CpuMonitor {
 public:
 	bool init();
 	bool getCpuPercent(double& outPercent);
+	// One entry per logical processor (first processor group only).
+	bool getCorePercents(std::vector<double>& outPercents);
 
 private:
 	CpuTimesSample _prev{};
 	bool _hasPrev{};
+	// Swapped every sample and reused, so steady-state sampling does not allocate.
+	std::vector<CpuTimesSample> _prevCores;
+	std::vector<CpuTimesSample> _curCores;
+	std::vector<unsigned char> _queryBuf;
 };
 
 } // namespace sysmon
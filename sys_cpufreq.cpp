@@ -0,0 +1,308 @@
+#include "sys_cpufreq.h"
+
+#if defined(_WIN32)
+#include "sys_pdh.h"
+
+#include <windows.h>
+#include <winternl.h>
+#include <powrprof.h>
+#include <pdh.h>
+
+#pragma comment(lib, "powrprof.lib")
+#pragma comment(lib, "pdh.lib")
+#elif defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#endif
+
+namespace sysmon {
+
+#if defined(_WIN32)
+
+// Layout documented for CallNtPowerInformation(ProcessorInformation) but not
+// declared by the SDK headers.
+struct ProcessorPowerInformation {
+	ULONG Number;
+	ULONG MaxMhz;
+	ULONG CurrentMhz;
+	ULONG MhzLimit;
+	ULONG MaxIdleState;
+	ULONG CurrentIdleState;
+};
+
+static constexpr double kKelvinOffset = 273.15;
+
+CpuFreqMonitor::~CpuFreqMonitor() {
+	if (_query && !_batch) PdhCloseQuery(static_cast<PDH_HQUERY>(_query));
+}
+
+bool CpuFreqMonitor::init(PdhBatch* batch) {
+	if (_query) return true;
+
+	PDH_HQUERY q{};
+	if (batch) q = static_cast<PDH_HQUERY>(batch->query());
+	else if (PdhOpenQueryW(nullptr, 0, &q) != ERROR_SUCCESS) return false;
+	if (!q) return false;
+
+	// Either counter may be missing (VMs, older builds); the rest still works.
+	PDH_HCOUNTER perfLimit{};
+	if (PdhAddEnglishCounterW(q, L"\\Processor Information(_Total)\\% Performance Limit", 0, &perfLimit) != ERROR_SUCCESS) perfLimit = nullptr;
+	PDH_HCOUNTER thermal{};
+	if (PdhAddEnglishCounterW(q, L"\\Thermal Zone Information(*)\\Temperature", 0, &thermal) != ERROR_SUCCESS) thermal = nullptr;
+
+	if (!perfLimit && !thermal) {
+		if (!batch) PdhCloseQuery(q);
+		return false;
+	}
+	// A shared query is primed by its owner once every collector has joined.
+	if (!batch) PdhCollectQueryData(q);
+	_batch = batch;
+	_query = q;
+	_perfLimit = perfLimit;
+	_thermal = thermal;
+	return true;
+}
+
+bool CpuFreqMonitor::initSysfs(const char*) {
+	return false;
+}
+
+static bool samplePowerInfo(std::vector<unsigned char>& buf, std::vector<CoreFreq>& out) {
+	SYSTEM_INFO si{};
+	GetSystemInfo(&si);
+	if (si.dwNumberOfProcessors == 0) return false;
+
+	const size_t count = si.dwNumberOfProcessors;
+	const size_t bytes = count * sizeof(ProcessorPowerInformation);
+	if (buf.size() < bytes) buf.resize(bytes);
+	auto* info = reinterpret_cast<ProcessorPowerInformation*>(buf.data());
+	if (CallNtPowerInformation(ProcessorInformation, nullptr, 0, info, static_cast<ULONG>(bytes)) != 0) return false;
+
+	out.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		out[i].currentMhz = info[i].CurrentMhz;
+		out[i].maxMhz = info[i].MaxMhz;
+		out[i].limitMhz = info[i].MhzLimit;
+	}
+	return true;
+}
+
+bool CpuFreqMonitor::sample(CpuFreqInfo& out) {
+	out.perfLimitPercent = {};
+	out.thermalZonesC.clear();
+	out.throttled = false;
+
+	const bool havePower = samplePowerInfo(_powerBuf, out.cores);
+	if (!havePower) out.cores.clear();
+
+	bool havePdh = false;
+	const bool collected = _batch ? _batch->collected() : _query && PdhCollectQueryData(static_cast<PDH_HQUERY>(_query)) == ERROR_SUCCESS;
+	if (_query && collected) {
+		havePdh = true;
+		if (_perfLimit) {
+			PDH_FMT_COUNTERVALUE v{};
+			if (PdhGetFormattedCounterValue(static_cast<PDH_HCOUNTER>(_perfLimit), PDH_FMT_DOUBLE, nullptr, &v) == ERROR_SUCCESS && v.CStatus == PDH_CSTATUS_VALID_DATA) {
+				out.perfLimitPercent = { true, v.doubleValue };
+			}
+		}
+		if (_thermal) {
+			DWORD size = 0;
+			DWORD count = 0;
+			auto counter = static_cast<PDH_HCOUNTER>(_thermal);
+			if (PdhGetFormattedCounterArrayW(counter, PDH_FMT_DOUBLE, &size, &count, nullptr) == PDH_MORE_DATA && size) {
+				if (_pdhBuf.size() < size) _pdhBuf.resize(size);
+				auto* items = reinterpret_cast<PDH_FMT_COUNTERVALUE_ITEM_W*>(_pdhBuf.data());
+				if (PdhGetFormattedCounterArrayW(counter, PDH_FMT_DOUBLE, &size, &count, items) == ERROR_SUCCESS) {
+					for (DWORD i = 0; i < count; ++i) {
+						if (items[i].FmtValue.CStatus != PDH_CSTATUS_VALID_DATA) continue;
+						out.thermalZonesC.push_back(items[i].FmtValue.doubleValue - kKelvinOffset);
+					}
+				}
+			}
+		}
+	}
+
+	for (const auto& c : out.cores) {
+		if (c.limitMhz && c.maxMhz && c.limitMhz < c.maxMhz) out.throttled = true;
+	}
+	if (out.perfLimitPercent.has && out.perfLimitPercent.value < 100.0) out.throttled = true;
+
+	out.ok = havePower || havePdh;
+	return out.ok;
+}
+
+#elif defined(__linux__)
+
+struct CoreFiles {
+	int cur{ -1 };       // cpufreq/scaling_cur_freq, kHz
+	int max{ -1 };       // cpufreq/cpuinfo_max_freq, kHz
+	int limit{ -1 };     // cpufreq/scaling_max_freq, kHz
+	int throttles{ -1 }; // thermal_throttle/core_throttle_count (x86 only)
+	std::uint64_t prevThrottles{};
+	bool hasPrev{};
+};
+
+struct CpuFreqMonitor::Sysfs {
+	std::vector<CoreFiles> cores; // in cpu number order
+	std::vector<int> thermal;     // thermal_zone*/temp, millidegrees C
+	char buf[64];
+};
+
+static void closeFd(int& fd) {
+	if (fd >= 0) close(fd);
+	fd = -1;
+}
+
+static int openFile(const std::string& path) {
+	return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+// Numeric suffixes of the "<prefix>N" entries in dir, ascending.
+static std::vector<unsigned> listNumbered(const std::string& dir, const char* prefix) {
+	std::vector<unsigned> ids;
+	DIR* d = opendir(dir.c_str());
+	if (!d) return ids;
+	const std::size_t plen = std::strlen(prefix);
+	while (dirent* e = readdir(d)) {
+		const char* name = e->d_name;
+		if (std::strncmp(name, prefix, plen) != 0 || name[plen] < '0' || name[plen] > '9') continue;
+		char* end = nullptr;
+		const unsigned long id = std::strtoul(name + plen, &end, 10);
+		if (*end == '\0') ids.push_back(static_cast<unsigned>(id));
+	}
+	closedir(d);
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+// sysfs attributes are one decimal number; temperatures may be negative.
+static bool readNumber(int fd, char* buf, std::size_t cap, std::int64_t& out) {
+	if (fd < 0) return false;
+	const ssize_t n = pread(fd, buf, cap - 1, 0);
+	if (n <= 0) return false;
+	buf[n] = '\0';
+	char* end = nullptr;
+	out = std::strtoll(buf, &end, 10);
+	return end != buf;
+}
+
+static std::uint32_t khzToMhz(std::int64_t khz) {
+	return khz > 0 ? static_cast<std::uint32_t>(khz / 1000) : 0;
+}
+
+CpuFreqMonitor::~CpuFreqMonitor() {
+	if (!_sysfs) return;
+	for (auto& c : _sysfs->cores) {
+		closeFd(c.cur);
+		closeFd(c.max);
+		closeFd(c.limit);
+		closeFd(c.throttles);
+	}
+	for (int& fd : _sysfs->thermal) closeFd(fd);
+	delete _sysfs;
+	_sysfs = nullptr;
+}
+
+bool CpuFreqMonitor::init(PdhBatch*) {
+	return initSysfs("/sys");
+}
+
+bool CpuFreqMonitor::initSysfs(const char* sysfsRoot) {
+	if (_sysfs) return true;
+
+	auto* fs = new Sysfs{};
+	const std::string cpuDir = std::string(sysfsRoot) + "/devices/system/cpu/cpu";
+	for (unsigned id : listNumbered(std::string(sysfsRoot) + "/devices/system/cpu", "cpu")) {
+		const std::string dir = cpuDir + std::to_string(id);
+		CoreFiles c;
+		c.cur = openFile(dir + "/cpufreq/scaling_cur_freq");
+		c.max = openFile(dir + "/cpufreq/cpuinfo_max_freq");
+		c.limit = openFile(dir + "/cpufreq/scaling_max_freq");
+		c.throttles = openFile(dir + "/thermal_throttle/core_throttle_count");
+		// No cpufreq driver (common in VMs): nothing worth a slot.
+		if (c.cur < 0 && c.max < 0) {
+			closeFd(c.limit);
+			closeFd(c.throttles);
+			continue;
+		}
+		fs->cores.push_back(c);
+	}
+	const std::string thermalDir = std::string(sysfsRoot) + "/class/thermal";
+	for (unsigned id : listNumbered(thermalDir, "thermal_zone")) {
+		const int fd = openFile(thermalDir + "/thermal_zone" + std::to_string(id) + "/temp");
+		if (fd >= 0) fs->thermal.push_back(fd);
+	}
+
+	if (fs->cores.empty() && fs->thermal.empty()) {
+		delete fs;
+		return false;
+	}
+	_sysfs = fs;
+	return true;
+}
+
+bool CpuFreqMonitor::sample(CpuFreqInfo& out) {
+	out.perfLimitPercent = {};
+	out.thermalZonesC.clear();
+	out.throttled = false;
+	if (!_sysfs) {
+		out.cores.clear();
+		out.ok = false;
+		return false;
+	}
+
+	char* buf = _sysfs->buf;
+	const std::size_t cap = sizeof(_sysfs->buf);
+	out.cores.resize(_sysfs->cores.size());
+	for (std::size_t i = 0; i < _sysfs->cores.size(); ++i) {
+		CoreFiles& f = _sysfs->cores[i];
+		CoreFreq& c = out.cores[i];
+		std::int64_t khz = 0;
+		c.currentMhz = readNumber(f.cur, buf, cap, khz) ? khzToMhz(khz) : 0;
+		c.maxMhz = readNumber(f.max, buf, cap, khz) ? khzToMhz(khz) : 0;
+		c.limitMhz = readNumber(f.limit, buf, cap, khz) ? khzToMhz(khz) : c.maxMhz;
+		if (c.limitMhz && c.maxMhz && c.limitMhz < c.maxMhz) out.throttled = true;
+
+		std::int64_t throttles = 0;
+		if (readNumber(f.throttles, buf, cap, throttles)) {
+			const auto count = static_cast<std::uint64_t>(throttles);
+			if (f.hasPrev && count > f.prevThrottles) out.throttled = true;
+			f.prevThrottles = count;
+			f.hasPrev = true;
+		}
+	}
+	for (int fd : _sysfs->thermal) {
+		std::int64_t milliC = 0;
+		if (readNumber(fd, buf, cap, milliC)) out.thermalZonesC.push_back(static_cast<double>(milliC) / 1000.0);
+	}
+
+	out.ok = true;
+	return true;
+}
+
+#else
+
+CpuFreqMonitor::~CpuFreqMonitor() = default;
+
+bool CpuFreqMonitor::init(PdhBatch*) {
+	return false;
+}
+
+bool CpuFreqMonitor::initSysfs(const char*) {
+	return false;
+}
+
+bool CpuFreqMonitor::sample(CpuFreqInfo& out) {
+	out = {};
+	return false;
+}
+
+#endif
+
+} // namespace sysmon
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "sys_cpu.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace sysmon {
+
+class PdhBatch;
+
+struct CoreFreq {
+	std::uint32_t currentMhz{};
+	std::uint32_t maxMhz{};
+	std::uint32_t limitMhz{}; // below maxMhz while the core is power/thermal limited
+};
+
+struct CpuFreqInfo {
+	std::vector<CoreFreq> cores;
+	// "% Performance Limit": below 100 means the package is being held back.
+	OptDbl perfLimitPercent;
+	std::vector<double> thermalZonesC;
+	bool throttled{};
+	bool ok{};
+};
+
+// Per-core frequency plus throttle/thermal indicators. The PDH query is
+// opened once in init() and re-collected on every sample; the handles are
+// kept as void* so this header stays free of <pdh.h>. Given a batch, the
+// counters go into its shared query instead, and sample() reads whatever
+// the batch's last collect() fetched.
+//
+// On Linux the same figures come from sysfs: cpu*/cpufreq and
+// thermal_zone*/temp are opened once and re-read with pread() on every
+// sample. There is no "% Performance Limit", so perfLimitPercent stays
+// unset; a core counts as throttled while scaling_max_freq sits below
+// cpuinfo_max_freq or its thermal_throttle count went up since last time.
+class CpuFreqMonitor {
+public:
+	CpuFreqMonitor() = default;
+	~CpuFreqMonitor();
+
+	CpuFreqMonitor(const CpuFreqMonitor&) = delete;
+	CpuFreqMonitor& operator=(const CpuFreqMonitor&) = delete;
+
+	bool init(PdhBatch* batch = nullptr);
+	// Linux: the sysfs mount to read (init() uses "/sys"); tests point it
+	// at a fake tree. Fails on other platforms.
+	bool initSysfs(const char* sysfsRoot);
+	bool sample(CpuFreqInfo& out);
+
+private:
+	struct Sysfs;
+
+	PdhBatch* _batch{};
+	void* _query{};
+	void* _perfLimit{};
+	void* _thermal{};
+	std::vector<unsigned char> _pdhBuf;
+	std::vector<unsigned char> _powerBuf;
+	Sysfs* _sysfs{};
+};
+
+} // namespace sysmon
@@ -0,0 +1,193 @@
+#include "sys_device.h"
+
+#include "sys_gpu.h"
+
+#include <windows.h>
+#include <iphlpapi.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+
+#pragma comment(lib, "iphlpapi.lib")
+
+namespace sysmon {
+
+std::string narrowUtf8(const std::wstring& ws) {
+	if (ws.empty()) return {};
+	int len = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, nullptr, 0, nullptr, nullptr);
+	if (len <= 0) return {};
+	std::string s(static_cast<size_t>(len - 1), '\0');
+	WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, &s[0], len, nullptr, nullptr);
+	return s;
+}
+
+std::wstring probeCpuName() {
+	HKEY hKey{};
+	if (RegOpenKeyExW(HKEY_LOCAL_MACHINE,
+		L"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0",
+		0,
+		KEY_QUERY_VALUE | KEY_WOW64_64KEY,
+		&hKey) != ERROR_SUCCESS) {
+		return {};
+	}
+
+	DWORD type = 0;
+	DWORD size = 0;
+	if (RegQueryValueExW(hKey, L"ProcessorNameString", nullptr, &type, nullptr, &size) != ERROR_SUCCESS || type != REG_SZ || size == 0) {
+		RegCloseKey(hKey);
+		return {};
+	}
+
+	std::wstring value(size / sizeof(wchar_t), L'\0');
+	if (RegQueryValueExW(hKey, L"ProcessorNameString", nullptr, &type, reinterpret_cast<LPBYTE>(&value[0]), &size) != ERROR_SUCCESS) {
+		RegCloseKey(hKey);
+		return {};
+	}
+	RegCloseKey(hKey);
+
+	while (!value.empty() && value.back() == L'\0') value.pop_back();
+	return value;
+}
+
+// Fills the fixed MAC/IP fields of the first non-loopback adapter. `buf`
+// persists across calls and only grows when the adapter list does.
+template <class NetIdT>
+static bool getPrimaryNetId(std::vector<unsigned char>& buf, NetIdT& out) {
+	out.mac[0] = '\0';
+	out.ipCount = 0;
+
+	ULONG size = static_cast<ULONG>(buf.size());
+	auto* info = reinterpret_cast<PIP_ADAPTER_INFO>(buf.data());
+	DWORD rc = GetAdaptersInfo(buf.empty() ? nullptr : info, &size);
+	if (rc == ERROR_BUFFER_OVERFLOW && size) {
+		buf.resize(size);
+		info = reinterpret_cast<PIP_ADAPTER_INFO>(buf.data());
+		rc = GetAdaptersInfo(info, &size);
+	}
+	if (rc != NO_ERROR) return false;
+
+	for (auto* a = info; a; a = a->Next) {
+		if (a->Type == MIB_IF_TYPE_LOOPBACK) continue;
+		if (a->AddressLength < 6) continue;
+
+		char* p = out.mac;
+		const char* end = out.mac + sizeof(out.mac);
+		for (UINT i = 0; i < a->AddressLength && end - p >= 4; ++i) {
+			p += std::snprintf(p, static_cast<size_t>(end - p), i ? ":%02x" : "%02x", a->Address[i]);
+		}
+
+		for (auto* ip = &a->IpAddressList; ip && out.ipCount < kMaxDeviceIps; ip = ip->Next) {
+			const char* s = ip->IpAddress.String;
+			if (s[0] == '\0' || std::strcmp(s, "0.0.0.0") == 0) continue;
+			std::snprintf(out.ips[out.ipCount++], sizeof(out.ips[0]), "%s", s);
+		}
+
+		if (out.mac[0] || out.ipCount) return true;
+	}
+
+	return false;
+}
+
+// Renders into the report's existing strings; same-length text reuses their capacity.
+static void formatDeviceInfo(DeviceReport& r) {
+	const DeviceInfo& d = r.info;
+	auto orNa = [](const char* s) { return s[0] ? s : "n/a"; };
+	auto name = [](const std::wstring& n, bool known) { return !known ? L"detecting..." : n.empty() ? L"n/a" : n.c_str(); };
+	auto ip = [&](std::size_t idx) { return idx < d.ipCount ? d.ips[idx] : "n/a"; };
+
+	wchar_t ram[32] = L"n/a";
+	if (d.mem.ok) {
+		std::swprintf(ram, 32, L"%.1f GB", static_cast<double>(d.mem.totalPhysBytes) / (1024.0 * 1024.0 * 1024.0));
+	}
+
+	// Lines of collectors the build leaves out are omitted, not shown as n/a.
+	wchar_t buf[1024];
+	constexpr int kCap = static_cast<int>(sizeof(buf) / sizeof(buf[0]));
+	int n = 0;
+	auto line = [&](const wchar_t* fmt, auto... args) {
+		const int k = std::swprintf(buf + n, static_cast<size_t>(kCap - n), fmt, args...);
+		if (k > 0) n += k;
+	};
+	line(L"CPU: %ls\r\n", name(d.cpuName, d.cpuNameKnown));
+	if constexpr (kBuiltWith<collect::Gpu>) line(L"GPU: %ls\r\n", name(d.gpuName, d.gpuNameKnown));
+	line(L"Total RAM: %ls\r\n", ram);
+	// Three distinct lines for IPs
+	if constexpr (kBuiltWith<collect::Network>) {
+		line(L"MAC: %hs\r\nIP1: %hs\r\nIP2: %hs\r\nIP3: %hs\r\n", orNa(d.mac), ip(0), ip(1), ip(2));
+	}
+	r.text.assign(buf, static_cast<size_t>(n));
+
+	const int len = WideCharToMultiByte(CP_UTF8, 0, r.text.c_str(), static_cast<int>(r.text.size()), nullptr, 0, nullptr, nullptr);
+	r.textUtf8.resize(len > 0 ? static_cast<size_t>(len) : 0);
+	if (len > 0) WideCharToMultiByte(CP_UTF8, 0, r.text.c_str(), static_cast<int>(r.text.size()), &r.textUtf8[0], len, nullptr, nullptr);
+}
+
+// Registry brand strings are at most 48 characters and DXGI adapter
+// descriptions 128, so these bound every report the pool will hold.
+static constexpr size_t kNameReserve = 128;
+static constexpr size_t kTextReserve = 512;
+
+// Applied to every pooled report and to any fallback the pool has to make.
+static void reserveReport(DeviceReport& r) {
+	r.info.cpuName.reserve(kNameReserve);
+	r.info.gpuName.reserve(kNameReserve);
+	r.text.reserve(kTextReserve);
+	r.textUtf8.reserve(kTextReserve * 3);
+	r.cpuNameUtf8.reserve(kNameReserve * 3);
+	r.gpuNameUtf8.reserve(kNameReserve * 3);
+}
+
+DeviceCollector::DeviceCollector(std::size_t reportSlots) : _reports(reportSlots, &reserveReport) {
+	// Nothing will ever deliver a GPU name, so do not wait for one.
+	_gpuNameKnown = !kBuiltWith<collect::Gpu>;
+}
+
+std::wstring probeGpuName() {
+	return getGpuVideoMemoryInfo().adapterName;
+}
+
+void DeviceCollector::setName(DeviceName which, const std::wstring& name) {
+	std::string utf8 = narrowUtf8(name);
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (which == DeviceName::Cpu) {
+		_cpuName = name;
+		_cpuNameUtf8 = std::move(utf8);
+		_cpuNameKnown = true;
+	} else {
+		_gpuName = name;
+		_gpuNameUtf8 = std::move(utf8);
+		_gpuNameKnown = true;
+	}
+}
+
+void DeviceCollector::probeNetwork() {
+	ifBuiltWith<collect::Network>(_adapterBuf, [this](auto& buf) {
+		NetId net;
+		getPrimaryNetId(buf, net);
+		std::lock_guard<std::mutex> lock(_mutex);
+		_net = net;
+	});
+}
+
+std::shared_ptr<const DeviceReport> DeviceCollector::collect() {
+	auto report = _reports.acquire();
+	DeviceInfo& d = report->info;
+	d.mem = getMemInfo();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		d.cpuName = _cpuName;
+		d.gpuName = _gpuName;
+		d.cpuNameKnown = _cpuNameKnown;
+		d.gpuNameKnown = _gpuNameKnown;
+		report->cpuNameUtf8 = _cpuNameUtf8;
+		report->gpuNameUtf8 = _gpuNameUtf8;
+		std::memcpy(d.mac, _net.mac, sizeof(d.mac));
+		std::memcpy(d.ips, _net.ips, sizeof(d.ips));
+		d.ipCount = _net.ipCount;
+	}
+	formatDeviceInfo(*report);
+	return report;
+}
+
+} // namespace sysmon
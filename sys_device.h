@@ -0,0 +1,94 @@
+#pragma once
+
+#include "sys_collectors.h"
+#include "sys_mem.h"
+#include "sys_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sysmon {
+
+constexpr std::size_t kMaxDeviceIps = 3;
+
+// Slow-changing device identity (registry, DXGI, IP Helper). Collecting it
+// is expensive, so it is refreshed on its own cadence and the rendered text
+// is shared by every snapshot until the next refresh. The address fields are
+// fixed-size so a refresh never needs the heap.
+struct DeviceInfo {
+	std::wstring cpuName;
+	std::wstring gpuName;
+	// False until the startup probe for that name has finished; the UI
+	// shows a placeholder instead of "n/a" meanwhile.
+	bool cpuNameKnown{};
+	bool gpuNameKnown{};
+	MemInfo mem;
+	char mac[24]{};                // "aa:bb:..", empty when unknown
+	char ips[kMaxDeviceIps][16]{}; // dotted IPv4
+	std::size_t ipCount{};
+};
+
+struct DeviceReport {
+	DeviceInfo info;
+	std::wstring text;    // shown in the UI
+	std::string textUtf8; // streamed over TCP
+	std::string cpuNameUtf8;
+	std::string gpuNameUtf8;
+};
+
+enum class DeviceName {
+	Cpu,
+	Gpu,
+};
+
+// The two slow, never-changing identity probes (registry and DXGI). They
+// block for a noticeable time on some machines, so they are run off the UI
+// and sampler threads and their results handed to DeviceCollector::setName().
+// probeGpuName() is only called when the build includes collect::Gpu.
+std::wstring probeCpuName();
+std::wstring probeGpuName();
+
+// collect() runs on the sampler thread and reuses a pooled report, so
+// periodic refreshes do not allocate; it never calls into IP Helper, it
+// copies whatever probeNetwork() found last. setName() may be called from
+// any thread. reportSlots must cover every report that can be held at once,
+// plus the one collect() is filling.
+class DeviceCollector {
+public:
+	explicit DeviceCollector(std::size_t reportSlots);
+
+	DeviceCollector(const DeviceCollector&) = delete;
+	DeviceCollector& operator=(const DeviceCollector&) = delete;
+
+	void setName(DeviceName which, const std::wstring& name);
+	// GetAdaptersInfo can block for tens to hundreds of milliseconds, so this
+	// runs on a thread of its own (one call at a time), never on the sampler's.
+	void probeNetwork();
+	std::shared_ptr<const DeviceReport> collect();
+
+private:
+	struct NetId {
+		char mac[24]{};
+		char ips[kMaxDeviceIps][16]{};
+		std::size_t ipCount{};
+	};
+
+	// Guards the names and _net, which other threads deliver.
+	std::mutex _mutex;
+	bool _cpuNameKnown{};
+	bool _gpuNameKnown{};
+	std::wstring _cpuName;
+	std::wstring _gpuName;
+	std::string _cpuNameUtf8;
+	std::string _gpuNameUtf8;
+	NetId _net;
+	BuiltState<collect::Network, std::vector<unsigned char>> _adapterBuf;
+	RecyclePool<DeviceReport> _reports;
+};
+
+std::string narrowUtf8(const std::wstring& ws);
+
+} // namespace sysmon
@@ -0,0 +1,269 @@
+#include "sys_encode.h"
+
+#include "sys_collectors.h"
+
+#include <cctype>
+#include <cstdio>
+
+namespace sysmon {
+
+bool parseEncoding(const std::string& name, Encoding& out) {
+	std::string n;
+	n.reserve(name.size());
+	for (char ch : name) n.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+
+	if (n == "text") out = Encoding::Text;
+	else if (n == "ndjson" || n == "json") out = Encoding::Ndjson;
+	else if (n == "csv") out = Encoding::Csv;
+	else if (n == "binary") out = Encoding::Binary;
+	else return false;
+	return true;
+}
+
+const char* encodingName(Encoding e) {
+	switch (e) {
+	case Encoding::Text: return "text";
+	case Encoding::Ndjson: return "ndjson";
+	case Encoding::Csv: return "csv";
+	case Encoding::Binary: return "binary";
+	default: return "?";
+	}
+}
+
+static constexpr std::size_t kStreamedCgroups = 8;
+
+// The frame layout is part of the protocol; these pin the two stock builds.
+static_assert(WireLayout<CollectorSet<collect::Cpu, collect::Mem>>::kSize == 72, "minimal frame layout changed");
+static_assert(WireLayout<CollectorSet<collect::Cpu, collect::Mem, collect::MemPressure, collect::Freq,
+	collect::Cgroup, collect::Network, collect::Gpu>>::kSize == 184, "full frame layout changed");
+
+static void appendU64(std::string& out, std::uint64_t v) {
+	char buf[24];
+	int n = std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v));
+	if (n > 0) out.append(buf, static_cast<std::size_t>(n));
+}
+
+static void appendDecimal(std::string& out, double v) {
+	char buf[32];
+	int n = std::snprintf(buf, sizeof(buf), "%.1f", v);
+	if (n > 0) out.append(buf, static_cast<std::size_t>(n));
+}
+
+static void appendJsonString(std::string& out, const char* s) {
+	out += '"';
+	for (; *s; ++s) {
+		const unsigned char ch = static_cast<unsigned char>(*s);
+		switch (ch) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if (ch < 0x20) {
+				char buf[8];
+				std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+				out += buf;
+			} else {
+				out += static_cast<char>(ch);
+			}
+		}
+	}
+	out += '"';
+}
+
+static void encodeNdjson(const Snapshot& snap, std::string& out) {
+	const Sample& s = snap.sample;
+	out += "{\"seq\":";
+	appendU64(out, s.seq);
+	out += ",\"mono_ns\":";
+	appendU64(out, s.monoNs);
+	out += ",\"wall_ns\":";
+	appendU64(out, s.wallNs);
+
+	out += ",\"cpu_pct\":";
+	if (s.cpuPercent.has) appendDecimal(out, s.cpuPercent.value);
+	else out += "null";
+	out += ",\"core_pct\":[";
+	for (std::size_t i = 0; i < s.corePercent.size(); ++i) {
+		if (i) out += ',';
+		appendDecimal(out, s.corePercent[i]);
+	}
+	out += "],\"cpu_period_ms\":";
+	appendU64(out, s.cpuPeriodMs);
+
+	if (s.mem.ok) {
+		out += ",\"mem_total_bytes\":";
+		appendU64(out, s.mem.totalPhysBytes);
+		out += ",\"mem_avail_bytes\":";
+		appendU64(out, s.mem.availPhysBytes);
+	}
+	out += ",\"mem_period_ms\":";
+	appendU64(out, s.memPeriodMs);
+
+	const MemPressure& mp = s.memPressure;
+	if (mp.ok) {
+		out += ",\"commit_bytes\":";
+		appendU64(out, mp.commitBytes);
+		out += ",\"commit_limit_bytes\":";
+		appendU64(out, mp.commitLimitBytes);
+		out += ",\"system_cache_bytes\":";
+		appendU64(out, mp.systemCacheBytes);
+		if (mp.haveLists) {
+			out += ",\"standby_bytes\":";
+			appendU64(out, mp.standbyBytes);
+			out += ",\"modified_bytes\":";
+			appendU64(out, mp.modifiedBytes);
+		}
+		if (mp.pageFaultsPerSec.has) {
+			out += ",\"page_faults_per_sec\":";
+			appendDecimal(out, mp.pageFaultsPerSec.value);
+		}
+		if (mp.hardFaultsPerSec.has) {
+			out += ",\"hard_faults_per_sec\":";
+			appendDecimal(out, mp.hardFaultsPerSec.value);
+		}
+		auto appendStall = [&](const char* key, const OptDbl& v) {
+			if (!v.has) return;
+			out += key;
+			appendDecimal(out, v.value);
+		};
+		appendStall(",\"mem_stall_some_avg10\":", mp.stallSomeAvg10);
+		appendStall(",\"mem_stall_some_avg60\":", mp.stallSomeAvg60);
+		appendStall(",\"mem_stall_full_avg10\":", mp.stallFullAvg10);
+		appendStall(",\"mem_stall_full_avg60\":", mp.stallFullAvg60);
+	}
+
+	if (s.freq.ok) {
+		auto appendMhz = [&](const char* key, std::uint32_t CoreFreq::*field) {
+			out += key;
+			out += '[';
+			for (std::size_t i = 0; i < s.freq.cores.size(); ++i) {
+				if (i) out += ',';
+				appendU64(out, s.freq.cores[i].*field);
+			}
+			out += ']';
+		};
+		appendMhz(",\"core_mhz\":", &CoreFreq::currentMhz);
+		appendMhz(",\"core_max_mhz\":", &CoreFreq::maxMhz);
+		appendMhz(",\"core_limit_mhz\":", &CoreFreq::limitMhz);
+		if (s.freq.perfLimitPercent.has) {
+			out += ",\"perf_limit_pct\":";
+			appendDecimal(out, s.freq.perfLimitPercent.value);
+		}
+		out += ",\"thermal_c\":[";
+		for (std::size_t i = 0; i < s.freq.thermalZonesC.size(); ++i) {
+			if (i) out += ',';
+			appendDecimal(out, s.freq.thermalZonesC[i]);
+		}
+		out += "],\"throttled\":";
+		out += s.freq.throttled ? "true" : "false";
+	}
+
+	if (s.cgroups) {
+		// The full hierarchy can hold hundreds of groups; stream the busiest.
+		// Selected by index so the shared vector is neither copied nor sorted.
+		const std::vector<CgroupUsage>& all = *s.cgroups;
+		std::size_t top[kStreamedCgroups];
+		std::size_t topCount = 0;
+		for (std::size_t i = 0; i < all.size(); ++i) {
+			std::size_t pos = topCount;
+			while (pos > 0 && all[top[pos - 1]].cpuPercent < all[i].cpuPercent) --pos;
+			if (pos >= kStreamedCgroups) continue;
+			if (topCount < kStreamedCgroups) ++topCount;
+			for (std::size_t j = topCount - 1; j > pos; --j) top[j] = top[j - 1];
+			top[pos] = i;
+		}
+		out += ",\"cgroups\":[";
+		for (std::size_t i = 0; i < topCount; ++i) {
+			const CgroupUsage& g = all[top[i]];
+			if (i) out += ',';
+			out += "{\"path\":";
+			appendJsonString(out, g.path.c_str());
+			out += ",\"cpu_pct\":";
+			appendDecimal(out, g.cpuPercent);
+			out += ",\"mem_bytes\":";
+			appendU64(out, g.memCurrentBytes);
+			out += ",\"mem_max_bytes\":";
+			appendU64(out, g.memMaxBytes);
+			out += ",\"io_read_bytes\":";
+			appendU64(out, g.ioReadBytes);
+			out += ",\"io_write_bytes\":";
+			appendU64(out, g.ioWriteBytes);
+			out += '}';
+		}
+		out += ']';
+	}
+
+	if (snap.device) {
+		const DeviceInfo& d = snap.device->info;
+		out += ",\"cpu_name\":";
+		appendJsonString(out, snap.device->cpuNameUtf8.c_str());
+		if constexpr (kBuiltWith<collect::Gpu>) {
+			out += ",\"gpu_name\":";
+			appendJsonString(out, snap.device->gpuNameUtf8.c_str());
+		}
+		if constexpr (kBuiltWith<collect::Network>) {
+			out += ",\"mac\":";
+			appendJsonString(out, d.mac);
+			out += ",\"ips\":[";
+			for (std::size_t i = 0; i < d.ipCount; ++i) {
+				if (i) out += ',';
+				appendJsonString(out, d.ips[i]);
+			}
+			out += ']';
+		}
+	}
+	out += "}\r\n";
+}
+
+std::string csvHeader() {
+	return "seq,wall_ns,mono_ns,cpu_pct,mem_total_bytes,mem_avail_bytes,cpu_period_ms,mem_period_ms\r\n";
+}
+
+// Unavailable values are left empty so spreadsheets treat them as blanks.
+static void encodeCsv(const Snapshot& snap, std::string& out) {
+	const Sample& s = snap.sample;
+	appendU64(out, s.seq);
+	out += ',';
+	appendU64(out, s.wallNs);
+	out += ',';
+	appendU64(out, s.monoNs);
+	out += ',';
+	if (s.cpuPercent.has) appendDecimal(out, s.cpuPercent.value);
+	out += ',';
+	if (s.mem.ok) appendU64(out, s.mem.totalPhysBytes);
+	out += ',';
+	if (s.mem.ok) appendU64(out, s.mem.availPhysBytes);
+	out += ',';
+	appendU64(out, s.cpuPeriodMs);
+	out += ',';
+	appendU64(out, s.memPeriodMs);
+	out += "\r\n";
+}
+
+std::string wireSchema() {
+	return BuildWireLayout::describe() + "\r\n";
+}
+
+void encodeSnapshot(const Snapshot& snap, Encoding e, std::string& out) {
+	out.clear();
+	switch (e) {
+	case Encoding::Ndjson: encodeNdjson(snap, out); break;
+	case Encoding::Csv: encodeCsv(snap, out); break;
+	case Encoding::Binary:
+		out.resize(BuildWireLayout::kSize);
+		BuildWireLayout::encode(snap.sample, reinterpret_cast<unsigned char*>(&out[0]));
+		break;
+	case Encoding::Text:
+	default:
+		if (snap.device) out += snap.device->textUtf8;
+		// Same clock as PING/PONG, so text clients can be aligned too.
+		out += "Mono ns: ";
+		appendU64(out, snap.sample.monoNs);
+		out += "\r\n";
+		break;
+	}
+}
+
+} // namespace sysmon
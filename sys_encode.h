@@ -0,0 +1,31 @@
+#pragma once
+
+#include "sys_snapshot.h"
+
+#include <cstddef>
+#include <string>
+
+namespace sysmon {
+
+enum class Encoding {
+	Text,   // the human-readable device block (default, what `nc` users see)
+	Ndjson, // one JSON object per line
+	Csv,    // one row per line; see csvHeader()
+	Binary, // fixed-size frames laid out by BuildWireLayout; see wireSchema()
+};
+
+constexpr std::size_t kEncodingCount = 4;
+
+// Accepts "text", "ndjson"/"json", "csv" and "binary" (case-insensitive).
+bool parseEncoding(const std::string& name, Encoding& out);
+const char* encodingName(Encoding e);
+
+// Renders one snapshot into out, replacing its contents; the result ends
+// with "\r\n", except for Binary, which is exactly one frame.
+// Reusing the same buffer each tick avoids reallocating it.
+void encodeSnapshot(const Snapshot& snap, Encoding e, std::string& out);
+std::string csvHeader();
+// The SCHEMA line describing the binary frame of this build.
+std::string wireSchema();
+
+} // namespace sysmon
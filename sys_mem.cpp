@@ -1,9 +1,28 @@
 #include "sys_mem.h"
 
+#if defined(_WIN32)
+#include "sys_pdh.h"
+
 #include <windows.h>
+#include <psapi.h>
+#include <pdh.h>
+
+#pragma comment(lib, "psapi.lib")
+#pragma comment(lib, "pdh.lib")
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#endif
 
 namespace sysmon {
 
+#if defined(_WIN32)
+
 MemInfo getMemInfo() {
 	MemInfo mi;
 	MEMORYSTATUSEX ms{};
@@ -15,4 +34,270 @@ MemInfo getMemInfo() {
 	return mi;
 }
 
+static const wchar_t* const kPressureCounters[] = {
+	L"\\Memory\\Page Faults/sec",
+	L"\\Memory\\Page Reads/sec", // one read per hard fault, however many pages it brings in
+	L"\\Memory\\Standby Cache Normal Priority Bytes",
+	L"\\Memory\\Standby Cache Reserve Bytes",
+	L"\\Memory\\Standby Cache Core Bytes",
+	L"\\Memory\\Modified Page List Bytes",
+};
+
+MemPressureMonitor::~MemPressureMonitor() {
+	if (_query && !_batch) PdhCloseQuery(static_cast<PDH_HQUERY>(_query));
+}
+
+bool MemPressureMonitor::init(PdhBatch* batch) {
+	if (_query) return true;
+
+	static_assert(sizeof(kPressureCounters) / sizeof(kPressureCounters[0]) == CounterCount, "counter table mismatch");
+
+	PDH_HQUERY q{};
+	if (batch) q = static_cast<PDH_HQUERY>(batch->query());
+	else if (PdhOpenQueryW(nullptr, 0, &q) != ERROR_SUCCESS) return false;
+	if (!q) return false;
+	for (int i = 0; i < CounterCount; ++i) {
+		PDH_HCOUNTER c{};
+		if (PdhAddEnglishCounterW(q, kPressureCounters[i], 0, &c) == ERROR_SUCCESS) _counters[i] = c;
+	}
+	_batch = batch;
+	_query = q;
+	return true;
+}
+
+bool MemPressureMonitor::initProc(const char*) {
+	return false;
+}
+
+bool MemPressureMonitor::sample(MemPressure& out) {
+	out = MemPressure{};
+
+	PERFORMANCE_INFORMATION pi{};
+	pi.cb = sizeof(pi);
+	if (GetPerformanceInfo(&pi, sizeof(pi))) {
+		const std::uint64_t page = static_cast<std::uint64_t>(pi.PageSize);
+		out.commitBytes = static_cast<std::uint64_t>(pi.CommitTotal) * page;
+		out.commitLimitBytes = static_cast<std::uint64_t>(pi.CommitLimit) * page;
+		out.systemCacheBytes = static_cast<std::uint64_t>(pi.SystemCache) * page;
+		out.ok = true;
+	}
+
+	const bool collected = _batch ? _batch->collected() : _query && PdhCollectQueryData(static_cast<PDH_HQUERY>(_query)) == ERROR_SUCCESS;
+	if (!_query || !collected) return out.ok;
+
+	// Raw values: cumulative counts for the /sec counters, bytes for the lists.
+	std::uint64_t raw[CounterCount]{};
+	bool have[CounterCount]{};
+	std::uint64_t stamp = 0;
+	for (int i = 0; i < CounterCount; ++i) {
+		if (!_counters[i]) continue;
+		PDH_RAW_COUNTER rc{};
+		if (PdhGetRawCounterValue(static_cast<PDH_HCOUNTER>(_counters[i]), nullptr, &rc) != ERROR_SUCCESS) continue;
+		if (rc.CStatus != PDH_CSTATUS_VALID_DATA && rc.CStatus != PDH_CSTATUS_NEW_DATA) continue;
+		raw[i] = static_cast<std::uint64_t>(rc.FirstValue);
+		have[i] = true;
+		if (i == PageFaults) stamp = (static_cast<std::uint64_t>(rc.TimeStamp.dwHighDateTime) << 32) | rc.TimeStamp.dwLowDateTime;
+	}
+
+	out.haveLists = have[StandbyNormal] || have[StandbyReserve] || have[StandbyCore] || have[ModifiedList];
+	out.standbyBytes = raw[StandbyNormal] + raw[StandbyReserve] + raw[StandbyCore];
+	out.modifiedBytes = raw[ModifiedList];
+
+	if (have[PageFaults] && have[HardFaultReads]) {
+		if (_hasPrev && stamp > _prevStamp && raw[PageFaults] >= _prevFaults && raw[HardFaultReads] >= _prevHardFaults) {
+			const double secs = static_cast<double>(stamp - _prevStamp) / 1e7;
+			out.pageFaultsPerSec = { true, static_cast<double>(raw[PageFaults] - _prevFaults) / secs };
+			out.hardFaultsPerSec = { true, static_cast<double>(raw[HardFaultReads] - _prevHardFaults) / secs };
+		}
+		_prevFaults = raw[PageFaults];
+		_prevHardFaults = raw[HardFaultReads];
+		_prevStamp = stamp;
+		_hasPrev = true;
+	}
+
+	out.ok = out.ok || out.haveLists;
+	return out.ok;
+}
+
+#elif defined(__linux__)
+
+static constexpr std::uint64_t kKiB = 1024;
+
+struct MemPressureMonitor::Proc {
+	int meminfo{ -1 };
+	int vmstat{ -1 };
+	int psi{ -1 }; // pressure/memory; absent without CONFIG_PSI
+	std::uint64_t prevUs{};
+	char buf[16384]; // /proc/vmstat runs to several KiB
+};
+
+static std::uint64_t monotonicUs() {
+	timespec ts{};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<std::uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<std::uint64_t>(ts.tv_nsec) / 1000ULL;
+}
+
+static void closeFd(int& fd) {
+	if (fd >= 0) close(fd);
+	fd = -1;
+}
+
+// procfs files report a size of 0 and may come back in several pieces, so
+// this reads from offset 0 until EOF or the buffer is full.
+static bool readAll(int fd, char* buf, std::size_t cap) {
+	if (fd < 0) return false;
+	std::size_t len = 0;
+	while (len + 1 < cap) {
+		const ssize_t n = pread(fd, buf + len, cap - 1 - len, static_cast<off_t>(len));
+		if (n <= 0) break;
+		len += static_cast<std::size_t>(n);
+	}
+	buf[len] = '\0';
+	return len > 0;
+}
+
+// Number after "<key>" at the start of a line, where key ends in ':' for
+// /proc/meminfo ("MemTotal:  123 kB") and in ' ' for /proc/vmstat.
+static bool findField(const char* text, const char* key, std::uint64_t& out) {
+	const std::size_t klen = std::strlen(key);
+	for (const char* p = text; p && *p;) {
+		if (std::strncmp(p, key, klen) == 0) {
+			out = std::strtoull(p + klen, nullptr, 10);
+			return true;
+		}
+		p = std::strchr(p, '\n');
+		if (p) ++p;
+	}
+	return false;
+}
+
+// "<kind> avg10=0.12 avg60=0.05 avg300=0.01 total=1234" in pressure/memory.
+static void findPsi(const char* text, const char* kind, OptDbl& avg10, OptDbl& avg60) {
+	const std::size_t klen = std::strlen(kind);
+	for (const char* p = text; p && *p;) {
+		const char* eol = std::strchr(p, '\n');
+		if (std::strncmp(p, kind, klen) == 0 && p[klen] == ' ') {
+			const char* a10 = std::strstr(p, "avg10=");
+			const char* a60 = std::strstr(p, "avg60=");
+			if (a10 && (!eol || a10 < eol)) avg10 = { true, std::strtod(a10 + 6, nullptr) };
+			if (a60 && (!eol || a60 < eol)) avg60 = { true, std::strtod(a60 + 6, nullptr) };
+			return;
+		}
+		p = eol ? eol + 1 : nullptr;
+	}
+}
+
+// One fd for the process, opened on first use.
+MemInfo getMemInfo() {
+	static const int fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+	MemInfo mi;
+	char buf[4096];
+	if (!readAll(fd, buf, sizeof(buf))) return mi;
+	std::uint64_t totalKb = 0;
+	std::uint64_t availKb = 0;
+	if (!findField(buf, "MemTotal:", totalKb) || !findField(buf, "MemAvailable:", availKb)) return mi;
+	mi.totalPhysBytes = totalKb * kKiB;
+	mi.availPhysBytes = availKb * kKiB;
+	mi.ok = true;
+	return mi;
+}
+
+MemPressureMonitor::~MemPressureMonitor() {
+	if (!_proc) return;
+	closeFd(_proc->meminfo);
+	closeFd(_proc->vmstat);
+	closeFd(_proc->psi);
+	delete _proc;
+	_proc = nullptr;
+}
+
+bool MemPressureMonitor::init(PdhBatch*) {
+	return initProc("/proc");
+}
+
+bool MemPressureMonitor::initProc(const char* procRoot) {
+	if (_proc) return true;
+
+	const std::string root = procRoot;
+	auto* proc = new Proc{};
+	proc->meminfo = open((root + "/meminfo").c_str(), O_RDONLY | O_CLOEXEC);
+	proc->vmstat = open((root + "/vmstat").c_str(), O_RDONLY | O_CLOEXEC);
+	proc->psi = open((root + "/pressure/memory").c_str(), O_RDONLY | O_CLOEXEC);
+	if (proc->meminfo < 0 && proc->vmstat < 0) {
+		closeFd(proc->psi);
+		delete proc;
+		return false;
+	}
+	_proc = proc;
+	return true;
+}
+
+bool MemPressureMonitor::sample(MemPressure& out) {
+	out = MemPressure{};
+	if (!_proc) return false;
+
+	char* buf = _proc->buf;
+	const std::size_t cap = sizeof(_proc->buf);
+	if (readAll(_proc->meminfo, buf, cap)) {
+		std::uint64_t kb = 0;
+		if (findField(buf, "Committed_AS:", kb)) {
+			out.commitBytes = kb * kKiB;
+			out.ok = true;
+		}
+		if (findField(buf, "CommitLimit:", kb)) out.commitLimitBytes = kb * kKiB;
+		if (findField(buf, "Cached:", kb)) out.systemCacheBytes = kb * kKiB;
+		if (findField(buf, "Inactive(file):", kb)) {
+			out.standbyBytes = kb * kKiB;
+			out.haveLists = true;
+		}
+		if (findField(buf, "Dirty:", kb)) out.modifiedBytes = kb * kKiB;
+		if (findField(buf, "Writeback:", kb)) out.modifiedBytes += kb * kKiB;
+	}
+
+	const std::uint64_t nowUs = monotonicUs();
+	std::uint64_t faults = 0;
+	std::uint64_t majFaults = 0;
+	if (readAll(_proc->vmstat, buf, cap) && findField(buf, "pgfault ", faults) && findField(buf, "pgmajfault ", majFaults)) {
+		if (_hasPrev && nowUs > _proc->prevUs && faults >= _prevFaults && majFaults >= _prevHardFaults) {
+			const double secs = static_cast<double>(nowUs - _proc->prevUs) / 1e6;
+			out.pageFaultsPerSec = { true, static_cast<double>(faults - _prevFaults) / secs };
+			out.hardFaultsPerSec = { true, static_cast<double>(majFaults - _prevHardFaults) / secs };
+		}
+		_prevFaults = faults;
+		_prevHardFaults = majFaults;
+		_proc->prevUs = nowUs;
+		_hasPrev = true;
+		out.ok = true;
+	}
+
+	if (readAll(_proc->psi, buf, cap)) {
+		findPsi(buf, "some", out.stallSomeAvg10, out.stallSomeAvg60);
+		findPsi(buf, "full", out.stallFullAvg10, out.stallFullAvg60);
+	}
+	return out.ok;
+}
+
+#else
+
+MemInfo getMemInfo() {
+	return {};
+}
+
+MemPressureMonitor::~MemPressureMonitor() = default;
+
+bool MemPressureMonitor::init(PdhBatch*) {
+	return false;
+}
+
+bool MemPressureMonitor::initProc(const char*) {
+	return false;
+}
+
+bool MemPressureMonitor::sample(MemPressure& out) {
+	out = MemPressure{};
+	return false;
+}
+
+#endif
+
 } // namespace sysmon
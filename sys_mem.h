@@ -1,8 +1,12 @@
 #pragma once
+#include "sys_cpu.h"
+
 #include <cstdint>
 
 namespace sysmon {
 
+class PdhBatch;
+
 struct MemInfo {
 	std::uint64_t totalPhysBytes{};
 	std::uint64_t availPhysBytes{};
@@ -11,4 +15,63 @@ struct MemInfo {
 
 MemInfo getMemInfo();
 
+// Whether the box is paging, not just how much RAM is free.
+struct MemPressure {
+	std::uint64_t commitBytes{};
+	std::uint64_t commitLimitBytes{};
+	std::uint64_t systemCacheBytes{};
+	std::uint64_t standbyBytes{};  // all standby priorities
+	std::uint64_t modifiedBytes{}; // dirty pages waiting to be written out
+	bool haveLists{};
+	OptDbl pageFaultsPerSec;
+	OptDbl hardFaultsPerSec; // disk reads resolving hard faults (operations, not pages)
+	// Linux PSI: percent of the last 10 s / 60 s in which some (or all
+	// non-idle) tasks were stalled waiting for memory. Unset elsewhere.
+	OptDbl stallSomeAvg10;
+	OptDbl stallSomeAvg60;
+	OptDbl stallFullAvg10;
+	OptDbl stallFullAvg60;
+	bool ok{};
+};
+
+// Rates are derived from the cumulative counters of the previous sample, so
+// each call is a single PDH collect plus GetPerformanceInfo. Given a batch,
+// the counters live in its shared query and sample() skips the collect; the
+// interval is taken from PDH's own collection timestamps either way, since a
+// batched collect can run well before sample() reads it.
+//
+// On Linux /proc/meminfo, /proc/vmstat and /proc/pressure/memory are opened
+// once and re-read with pread(): Committed_AS / CommitLimit / Cached stand in
+// for the commit and cache figures, Inactive(file) for standby and
+// Dirty + Writeback for modified, and the fault rates come from the
+// pgfault / pgmajfault deltas over the monotonic clock.
+class MemPressureMonitor {
+public:
+	MemPressureMonitor() = default;
+	~MemPressureMonitor();
+
+	MemPressureMonitor(const MemPressureMonitor&) = delete;
+	MemPressureMonitor& operator=(const MemPressureMonitor&) = delete;
+
+	bool init(PdhBatch* batch = nullptr);
+	// Linux: the procfs mount to read (init() uses "/proc"); tests point it
+	// at a fixture directory. Fails on other platforms.
+	bool initProc(const char* procRoot);
+	bool sample(MemPressure& out);
+
+private:
+	struct Proc;
+
+	enum Counter { PageFaults, HardFaultReads, StandbyNormal, StandbyReserve, StandbyCore, ModifiedList, CounterCount };
+
+	PdhBatch* _batch{};
+	void* _query{};
+	void* _counters[CounterCount]{};
+	std::uint64_t _prevFaults{};
+	std::uint64_t _prevHardFaults{};
+	std::uint64_t _prevStamp{}; // FILETIME of the previous collect, 100 ns units
+	bool _hasPrev{};
+	Proc* _proc{};
+};
+
 } // namespace sysmon
@@ -0,0 +1,27 @@
+#include "sys_pdh.h"
+
+#include <windows.h>
+#include <pdh.h>
+
+#pragma comment(lib, "pdh.lib")
+
+namespace sysmon {
+
+PdhBatch::~PdhBatch() {
+	if (_query) PdhCloseQuery(static_cast<PDH_HQUERY>(_query));
+}
+
+bool PdhBatch::open() {
+	if (_query) return true;
+	PDH_HQUERY q{};
+	if (PdhOpenQueryW(nullptr, 0, &q) != ERROR_SUCCESS) return false;
+	_query = q;
+	return true;
+}
+
+bool PdhBatch::collect() {
+	_collected = _query && PdhCollectQueryData(static_cast<PDH_HQUERY>(_query)) == ERROR_SUCCESS;
+	return _collected;
+}
+
+} // namespace sysmon
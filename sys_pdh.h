@@ -0,0 +1,30 @@
+#pragma once
+
+namespace sysmon {
+
+// One PDH query that several collectors add their counters to, so a tick
+// that samples them together costs a single PdhCollectQueryData instead of
+// one per collector. The handle is kept as void* so this header stays free
+// of <pdh.h>.
+class PdhBatch {
+public:
+	PdhBatch() = default;
+	~PdhBatch();
+
+	PdhBatch(const PdhBatch&) = delete;
+	PdhBatch& operator=(const PdhBatch&) = delete;
+
+	bool open();
+	void* query() const { return _query; }
+
+	// Once per tick, before the collectors sharing it read their counters.
+	bool collect();
+	// Whether the last collect() succeeded.
+	bool collected() const { return _collected; }
+
+private:
+	void* _query{};
+	bool _collected{};
+};
+
+} // namespace sysmon
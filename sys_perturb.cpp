@@ -0,0 +1,137 @@
+#include "sys_perturb.h"
+
+#include "sys_clock.h"
+#include "sys_encode.h"
+#include "sys_thread_policy.h"
+
+#include <windows.h>
+
+#include <cstdio>
+
+namespace sysmon {
+
+// Anything shorter is the loop itself (one clock read and a compare).
+static constexpr std::uint64_t kGapNs = 1000;
+
+struct SpinRun {
+	unsigned core{};
+	std::uint32_t durationMs{};
+	std::uint64_t spinNs{};
+	std::uint64_t stolenNs{};
+	JitterHistogram gaps;
+};
+
+static DWORD WINAPI spinThread(LPVOID p) {
+	auto* run = reinterpret_cast<SpinRun*>(p);
+	ThreadPolicy pin;
+	pin.affinityMask = 1ULL << run->core;
+	applyThreadPolicy(pin);
+
+	const std::uint64_t start = monotonicNs();
+	const std::uint64_t end = start + static_cast<std::uint64_t>(run->durationMs) * 1000000ULL;
+	std::uint64_t prev = start;
+	std::uint64_t stolen = 0;
+	for (;;) {
+		const std::uint64_t now = monotonicNs();
+		const std::uint64_t gap = now - prev;
+		if (gap > kGapNs) {
+			stolen += gap;
+			run->gaps.record(gap);
+		}
+		prev = now;
+		if (now >= end) break;
+	}
+	run->spinNs = prev - start;
+	run->stolenNs = stolen;
+	return 0;
+}
+
+static void spinPhase(const char* name, SpinRun& run, std::string& out) {
+	HANDLE t = CreateThread(nullptr, 0, spinThread, &run, 0, nullptr);
+	if (!t) {
+		out += "PERTURB ";
+		out += name;
+		out += " failed\r\n";
+		return;
+	}
+	WaitForSingleObject(t, INFINITE);
+	CloseHandle(t);
+
+	char buf[96];
+	const unsigned long long ppm = run.spinNs ? (run.stolenNs * 1000000ULL) / run.spinNs : 0;
+	std::snprintf(buf, sizeof(buf), "PERTURB %s stolen_us=%llu stolen_ppm=%llu ", name,
+		static_cast<unsigned long long>(run.stolenNs / 1000), ppm);
+	out += buf;
+	out += run.gaps.format();
+}
+
+// Streams every tick as ndjson into a scratch buffer, as one connected
+// client would make the server do, so the "on" phases include that work.
+static void monitorPhase(const char* name, const SamplerConfig& cfg, SpinRun& run, std::string& out) {
+	Sampler* sampler = nullptr;
+	std::string line;
+	line.reserve(8192); // grown up front, the tick may run under the allocation guard
+	Sampler s([&sampler, &line](const Sample& sample) {
+		if (!sample.streamTick || !sampler) return;
+		if (auto snap = sampler->latest()) encodeSnapshot(*snap, Encoding::Ndjson, line);
+	});
+	sampler = &s;
+	if (!s.start(cfg)) {
+		out += "PERTURB ";
+		out += name;
+		out += " failed: sampler did not start\r\n";
+		return;
+	}
+	// Let the collectors open their queries before measuring.
+	Sleep(2 * (cfg.basePeriodMs ? cfg.basePeriodMs : 1000));
+	spinPhase(name, run, out);
+	s.stop();
+}
+
+std::string runPerturbationBench(const PerturbBenchConfig& cfg) {
+	std::string out;
+	if (cfg.spinCore > 63) return "PERTURB failed: spin core out of range\r\n";
+
+	std::uint64_t housekeeping = cfg.housekeepingMask;
+	if (!housekeeping) {
+		DWORD_PTR process = 0;
+		DWORD_PTR system = 0;
+		if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+			housekeeping = static_cast<std::uint64_t>(process) & ~(1ULL << cfg.spinCore);
+		}
+	}
+	if (!housekeeping || (housekeeping & (1ULL << cfg.spinCore))) {
+		return "PERTURB failed: housekeeping set must exclude the spin core\r\n";
+	}
+
+	char buf[96];
+	std::snprintf(buf, sizeof(buf), "PERTURB spin_core=%u phase_ms=%u housekeeping=0x%llx\r\n",
+		cfg.spinCore, cfg.phaseMs, static_cast<unsigned long long>(housekeeping));
+	out += buf;
+
+	SpinRun off;
+	off.core = cfg.spinCore;
+	off.durationMs = cfg.phaseMs;
+	spinPhase("off", off, out);
+
+	SamplerConfig on = cfg.sampler;
+	on.thread = ThreadPolicy{};
+	on.batchQueries = false;
+	SpinRun onRun;
+	onRun.core = cfg.spinCore;
+	onRun.durationMs = cfg.phaseMs;
+	monitorPhase("on", on, onRun, out);
+
+	SamplerConfig low = cfg.sampler;
+	low.thread.affinityMask = housekeeping;
+	low.thread.background = true;
+	low.batchQueries = true;
+	SpinRun lowRun;
+	lowRun.core = cfg.spinCore;
+	lowRun.durationMs = cfg.phaseMs;
+	monitorPhase("low", low, lowRun, out);
+
+	return out;
+}
+
+} // namespace sysmon
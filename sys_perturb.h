@@ -0,0 +1,32 @@
+#pragma once
+
+#include "sys_sampler.h"
+
+#include <cstdint>
+#include <string>
+
+namespace sysmon {
+
+// Measures what the monitor costs a co-located latency-sensitive workload.
+// A thread pinned to spinCore spins on the clock and counts every gap
+// longer than a microsecond as time taken from it (interrupts, preemption,
+// cache and frequency effects of the monitor's own work). The same spin is
+// run with the monitor off, with the default sampler, and with the
+// low-perturbation sampler (housekeeping affinity, background priority,
+// batched queries), one phase after the other.
+struct PerturbBenchConfig {
+	unsigned spinCore{};
+	std::uint32_t phaseMs{ 10000 };
+	// Cores the low-perturbation phase may use; 0 = every core of the
+	// process affinity except spinCore.
+	std::uint64_t housekeepingMask{};
+	SamplerConfig sampler; // base settings for both monitor-on phases
+};
+
+// One line per phase:
+//   "PERTURB <off|on|low> stolen_us=<n> stolen_ppm=<n> JITTER count=<gaps> max_us=<m> b0=.."
+// where the JITTER part is the gap histogram (see JitterHistogram). Blocks
+// for three phases.
+std::string runPerturbationBench(const PerturbBenchConfig& cfg);
+
+} // namespace sysmon
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "sys_alloc_guard.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace sysmon {
+
+// Fixed set of heap objects that are handed out as shared_ptr and recycled
+// once every reader has dropped them. Readers of a published object
+// therefore never see it change, and steady-state publishing allocates
+// nothing. acquire() falls back to a fresh allocation only when every slot
+// is still in use.
+//
+// Each slot carries an explicit in-use flag and the storage for the
+// shared_ptr control block that hands it out. The block's allocator clears
+// the flag (release) as the very last step of the last reader's release,
+// and acquire() claims it (acquire), so every read of the old value happens
+// before the slot is written again. The slots themselves are reference
+// counted and outlive the pool if a reader still holds one.
+//
+// Two optional hooks, plain functions so nothing is captured: `prepare` runs
+// on every slot up front and on each fallback object, typically to reserve
+// capacity, so a fallback is shaped like a pooled value; `recycle` runs as
+// the last reader lets go, before the slot is marked idle, to drop what an
+// idle slot should not keep alive (e.g. shared_ptrs into other pools).
+//
+// acquire() and forEachIdle() are meant for a single owning thread; the
+// handed-out pointers may be dropped on any thread, so `recycle` may run
+// on any thread too.
+template <class T>
+class RecyclePool {
+public:
+	using Hook = void (*)(T&);
+
+	explicit RecyclePool(std::size_t slots = 4, Hook prepare = nullptr, Hook recycle = nullptr)
+		: _store(new Store(slots, recycle)), _prepare(prepare) {
+		if (_prepare) forEachIdle(_prepare);
+	}
+	~RecyclePool() { _store->release(); }
+
+	RecyclePool(const RecyclePool&) = delete;
+	RecyclePool& operator=(const RecyclePool&) = delete;
+
+	// Runs f on every idle slot, typically to reserve or copy in a
+	// representative value so later reuse finds the capacity already there.
+	template <class F>
+	void forEachIdle(F f) {
+		for (std::size_t i = 0; i < _store->count; ++i) {
+			Slot& s = _store->slots[i];
+			if (!s.claim()) continue;
+			f(s.value);
+			s.inUse.store(false, std::memory_order_release);
+		}
+	}
+
+	std::shared_ptr<T> acquire() {
+		const std::size_t n = _store->count;
+		for (std::size_t i = 0; i < n; ++i) {
+			Slot& s = _store->slots[(_next + i) % n];
+			if (!s.claim()) continue;
+			_next = (_next + i + 1) % n;
+			_store->refs.fetch_add(1, std::memory_order_relaxed);
+			return std::shared_ptr<T>(&s.value, Keep{}, BlockAlloc<T>(&s, _store));
+		}
+		++_misses;
+		// Every slot is pinned by a slow reader: worth a heap allocation
+		// rather than overwriting something still being read, but reported,
+		// since it means the pool is sized too small.
+		allocGuardNotePoolMiss();
+		AllocGuardExempt exempt;
+		auto fallback = std::make_shared<T>();
+		if (_prepare) _prepare(*fallback);
+		return fallback;
+	}
+
+	std::size_t misses() const { return _misses; }
+
+private:
+	// Fits the control block of a shared_ptr with an empty deleter and a
+	// two-pointer allocator on the common standard libraries.
+	static constexpr std::size_t kBlockBytes = 64;
+
+	struct Slot {
+		T value{};
+		std::atomic<bool> inUse{ false };
+		alignas(std::max_align_t) unsigned char block[kBlockBytes];
+
+		bool claim() {
+			bool idle = false;
+			return inUse.compare_exchange_strong(idle, true, std::memory_order_acquire, std::memory_order_relaxed);
+		}
+	};
+
+	struct Store {
+		Store(std::size_t n, Hook onRecycle) : slots(new Slot[n]), count(n), recycle(onRecycle) {}
+
+		void release() {
+			if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+		}
+
+		std::unique_ptr<Slot[]> slots;
+		std::size_t count;
+		Hook recycle;
+		std::atomic<std::size_t> refs{ 1 }; // the pool plus one per handed-out slot
+	};
+
+	// The value lives on in its slot; only the control block goes away.
+	struct Keep {
+		void operator()(T*) const noexcept {}
+	};
+
+	template <class U>
+	struct BlockAlloc {
+		using value_type = U;
+
+		Slot* slot;
+		Store* store;
+
+		BlockAlloc(Slot* s, Store* st) noexcept : slot(s), store(st) {}
+		template <class V>
+		BlockAlloc(const BlockAlloc<V>& o) noexcept : slot(o.slot), store(o.store) {}
+
+		U* allocate(std::size_t n) {
+			if (n * sizeof(U) <= kBlockBytes && alignof(U) <= alignof(std::max_align_t)) return reinterpret_cast<U*>(slot->block);
+			return static_cast<U*>(::operator new(n * sizeof(U)));
+		}
+
+		void deallocate(U* p, std::size_t) noexcept {
+			if (reinterpret_cast<unsigned char*>(p) != slot->block) ::operator delete(p);
+			Store* st = store;
+			if (st->recycle) st->recycle(slot->value);
+			slot->inUse.store(false, std::memory_order_release);
+			st->release();
+		}
+
+		template <class V>
+		bool operator==(const BlockAlloc<V>& o) const noexcept { return slot == o.slot; }
+		template <class V>
+		bool operator!=(const BlockAlloc<V>& o) const noexcept { return slot != o.slot; }
+	};
+
+	Store* _store;
+	Hook _prepare;
+	std::size_t _next{};
+	std::size_t _misses{};
+};
+
+} // namespace sysmon
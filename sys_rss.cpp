@@ -1,12 +1,21 @@
 #include "sys_rss.h"
 
+#if defined(_WIN32)
 #include <windows.h>
 #include <psapi.h>
 
 #pragma comment(lib, "psapi.lib")
+#else
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#endif
 
 namespace sysmon {
 
+#if defined(_WIN32)
+
 std::uint64_t getProcessRssBytes() {
 	PROCESS_MEMORY_COUNTERS_EX pmc{};
 	pmc.cb = sizeof(pmc);
@@ -16,4 +25,22 @@ std::uint64_t getProcessRssBytes() {
 	return 0;
 }
 
+#else
+
+// /proc/self/statm: "<size> <resident> ..." in pages.
+std::uint64_t getProcessRssBytes() {
+	const int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return 0;
+	char buf[128];
+	const ssize_t n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n <= 0) return 0;
+	buf[n] = '\0';
+	unsigned long long size = 0, resident = 0;
+	if (std::sscanf(buf, "%llu %llu", &size, &resident) != 2) return 0;
+	return static_cast<std::uint64_t>(resident) * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+#endif
+
 } // namespace sysmon
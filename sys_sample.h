@@ -0,0 +1,46 @@
+#pragma once
+
+#include "sys_cgroup.h"
+#include "sys_cpu.h"
+#include "sys_cpufreq.h"
+#include "sys_mem.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sysmon {
+
+// One tick worth of fast-changing metrics, collected by Sampler.
+struct Sample {
+	std::uint64_t seq{};
+	// Taken right after the scheduled wake-up; wallNs is Unix-epoch based.
+	// monoNs is the clock PING replies are stamped with (see clock_sync.h),
+	// so clients can map it onto their own timeline.
+	std::uint64_t monoNs{};
+	std::uint64_t wallNs{};
+	// Set on the ticks that fall on a basePeriodMs wall-clock boundary; these
+	// drive the TCP stream so every client (and host) is phase-aligned.
+	bool streamTick{};
+	OptDbl cpuPercent;
+	std::vector<double> corePercent;
+	MemInfo mem;
+	MemPressure memPressure; // refreshed together with mem
+	CpuFreqInfo freq;
+	// Shared rather than copied per tick; null where cgroups are unavailable.
+	std::shared_ptr<const std::vector<CgroupUsage>> cgroups;
+
+	// Collectors run on their own adaptive cadence; the ones that did not
+	// run this tick carry their previous values with the flag cleared.
+	bool cpuFresh{};
+	bool memFresh{};
+	bool freqFresh{};
+	bool cgroupFresh{};
+	bool deviceFresh{};
+	// Period each collector is currently sampled at, so consumers can tell a
+	// deliberately sparse stretch from missing data.
+	std::uint32_t cpuPeriodMs{};
+	std::uint32_t memPeriodMs{};
+};
+
+} // namespace sysmon
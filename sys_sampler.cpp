@@ -0,0 +1,438 @@
+#include "sys_sampler.h"
+
+#include "sys_alloc_guard.h"
+#include "sys_collectors.h"
+#include "sys_pdh.h"
+#include "sys_pool.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace sysmon {
+
+static constexpr std::uint64_t kNsPerMs = 1000000ULL;
+// Deadline of a collector the build leaves out.
+static constexpr std::uint64_t kNever = ~0ULL;
+// Published snapshots stay pinned by the store, `last` and whichever readers
+// are mid-render; these counts leave headroom over that.
+static constexpr std::size_t kSnapshotSlots = 6;
+static constexpr std::size_t kCgroupListSlots = 4;
+// A device report is held by each live snapshot, by Impl::device, by the
+// UI's shownDevice and by the one collect() is filling.
+static constexpr std::size_t kDeviceReportSlots = kSnapshotSlots + 3;
+
+// An idle snapshot slot must not pin the device report or cgroup list it
+// last carried; those pools are sized for live snapshots only.
+static void dropReferences(Snapshot& snap) {
+	snap.device.reset();
+	snap.sample.cgroups.reset();
+}
+
+struct Sampler::Impl {
+	TickHandler onTick;
+	SamplerConfig cfg;
+	// Collectors left out of BuildCollectors shrink to NotBuilt, so neither
+	// their code nor their DLL imports end up in the binary.
+	BuiltState<collect::Cpu, CpuMonitor> cpuMon;
+	BuiltState<collect::Freq, CpuFreqMonitor> freqMon;
+	BuiltState<collect::Cgroup, CgroupMonitor> cgroupMon;
+	bool haveCgroups{};
+	BuiltState<collect::MemPressure, MemPressureMonitor> memPressureMon;
+	std::conditional_t<kBuiltWith<collect::Freq> || kBuiltWith<collect::MemPressure>, PdhBatch, NotBuilt> pdh;
+	PdhBatch* batch{}; // &pdh while cfg.batchQueries is in effect
+	AdaptiveRate cpuRate;
+	AdaptiveRate memRate;
+	// Deadlines in wallClockNs() units, always on a multiple of gridNs.
+	std::uint64_t gridNs{};
+	std::uint64_t cpuDue{};
+	std::uint64_t memDue{};
+	std::uint64_t streamDue{};
+	std::uint64_t deviceDue{};
+	std::uint64_t freqDue{};
+	std::uint64_t cgroupDue{};
+	Sample last;
+	DeviceCollector deviceCollector{ kDeviceReportSlots };
+	std::shared_ptr<const DeviceReport> device;
+	RecyclePool<Snapshot> snapshots{ kSnapshotSlots, nullptr, &dropReferences };
+	RecyclePool<std::vector<CgroupUsage>> cgroupLists{ kCgroupListSlots };
+	bool warm{};
+	SnapshotStore store;
+	JitterHistogram jitter;
+	HANDLE stopEvent{};
+	HANDLE refreshEvent{}; // auto-reset; lives as long as the Sampler
+	HANDLE timer{};
+	HANDLE thread{};
+	// Network builds only: the IP Helper lookup runs on netThread, woken by
+	// the auto-reset netRequest, and its result is published through
+	// refreshEvent, so a slow adapter query never delays a tick.
+	HANDLE netRequest{};
+	HANDLE netThread{};
+
+	enum class Wake { Deadline, Refresh, Stop };
+
+	void initCollectors();
+	void startNetProbe();
+	void schedule(std::uint64_t now);
+	Wake waitUntil(std::uint64_t deadline);
+	void tick(std::uint64_t deadline);
+	void refreshDevice();
+	void publish();
+	void warmUp();
+};
+
+Sampler::Sampler(TickHandler onTick) : _impl(new Impl{}) {
+	_impl->onTick = std::move(onTick);
+	_impl->refreshEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+}
+
+Sampler::~Sampler() {
+	stop();
+	if (_impl->refreshEvent) CloseHandle(_impl->refreshEvent);
+	delete _impl;
+	_impl = nullptr;
+}
+
+void Sampler::setDeviceName(DeviceName which, const std::wstring& name) {
+	_impl->deviceCollector.setName(which, name);
+	if (_impl->refreshEvent) SetEvent(_impl->refreshEvent);
+}
+
+const JitterHistogram& Sampler::jitter() const {
+	return _impl->jitter;
+}
+
+std::shared_ptr<const Snapshot> Sampler::latest() const {
+	return _impl->store.latest();
+}
+
+static constexpr double kCpuWatchMargin = 10.0;
+static constexpr double kMemWatchMargin = 5.0;
+
+void watchAlertRules(SamplerConfig& cfg, const std::vector<AlertRule>& rules) {
+	const double inf = std::numeric_limits<double>::infinity();
+	cfg.cpuWatchPercent = inf;
+	cfg.memWatchAvailPercent = -inf;
+	for (const auto& r : rules) {
+		switch (r.metric) {
+		case AlertMetric::CpuTotalPercent:
+		case AlertMetric::CpuCorePercent:
+			if (r.compare == AlertCompare::Above) cfg.cpuWatchPercent = std::min(cfg.cpuWatchPercent, r.threshold - kCpuWatchMargin);
+			break;
+		case AlertMetric::MemAvailPercent:
+			if (r.compare == AlertCompare::Below) cfg.memWatchAvailPercent = std::max(cfg.memWatchAvailPercent, r.threshold + kMemWatchMargin);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// Smallest multiple of step that is >= t.
+static std::uint64_t ceilTo(std::uint64_t t, std::uint64_t step) {
+	return ((t + step - 1) / step) * step;
+}
+
+static std::uint32_t collectCpu(CpuMonitor& cpuMon, AdaptiveRate& rate, const SamplerConfig& cfg, Sample& s) {
+	double pct = 0.0;
+	if (cpuMon.getCpuPercent(pct)) s.cpuPercent = { true, pct };
+	if (!cpuMon.getCorePercents(s.corePercent)) s.corePercent.clear();
+	s.cpuFresh = true;
+	if (!cfg.adaptive) return cfg.basePeriodMs;
+
+	double hottest = s.cpuPercent.has ? s.cpuPercent.value : 0.0;
+	for (double c : s.corePercent) hottest = std::max(hottest, c);
+	return rate.update(s.cpuPercent.has ? s.cpuPercent.value : 0.0, hottest >= cfg.cpuWatchPercent);
+}
+
+static std::uint32_t collectMem(AdaptiveRate& rate, const SamplerConfig& cfg, Sample& s) {
+	s.mem = getMemInfo();
+	s.memFresh = true;
+	if (!cfg.adaptive || !s.mem.ok || s.mem.totalPhysBytes == 0) return cfg.basePeriodMs;
+
+	const double availPct = (static_cast<double>(s.mem.availPhysBytes) * 100.0) / static_cast<double>(s.mem.totalPhysBytes);
+	return rate.update(availPct, availPct <= cfg.memWatchAvailPercent);
+}
+
+// Opening the PDH queries can take hundreds of milliseconds, so this runs on
+// the sampler thread rather than in start() on the caller's (UI) thread.
+void Sampler::Impl::initCollectors() {
+	ifBuiltWith<collect::Freq, collect::MemPressure>(pdh, [this](auto& q) {
+		if (cfg.batchQueries && q.open()) batch = &q;
+	});
+	ifBuiltWith<collect::Cpu>(cpuMon, [](auto& mon) { mon.init(); });
+	ifBuiltWith<collect::Freq>(freqMon, [this](auto& mon) { mon.init(batch); });
+	ifBuiltWith<collect::Cgroup>(cgroupMon, [this](auto& mon) { haveCgroups = mon.init(); });
+	ifBuiltWith<collect::MemPressure>(memPressureMon, [this](auto& mon) { mon.init(batch); });
+	// Rate counters need a previous collect before the first tick reads them.
+	ifBuiltWith<collect::Freq, collect::MemPressure>(pdh, [this](auto& q) {
+		if (batch) q.collect();
+	});
+}
+
+void Sampler::Impl::schedule(std::uint64_t now) {
+	const std::uint64_t first = ceilTo(now + 1, cfg.basePeriodMs * kNsPerMs);
+	streamDue = deviceDue = first;
+	cpuDue = kBuiltWith<collect::Cpu> ? first : kNever;
+	memDue = kBuiltWith<collect::Mem> ? first : kNever;
+	freqDue = kBuiltWith<collect::Freq> ? first : kNever;
+	cgroupDue = kBuiltWith<collect::Cgroup> ? first : kNever;
+}
+
+// Stop wins over a pending refresh, and a refresh over a due deadline (the
+// deadline is still due on the next call).
+Sampler::Impl::Wake Sampler::Impl::waitUntil(std::uint64_t deadline) {
+	HANDLE handles[3] = { stopEvent, refreshEvent, timer };
+	auto wakeFor = [](DWORD r) {
+		if (r == WAIT_OBJECT_0 + 1) return Wake::Refresh;
+		if (r == WAIT_TIMEOUT || r == WAIT_OBJECT_0 + 2) return Wake::Deadline;
+		return Wake::Stop;
+	};
+
+	const std::uint64_t now = wallClockNs();
+	if (deadline <= now) return wakeFor(WaitForMultipleObjects(2, handles, FALSE, 0));
+
+	// Relative due time (negative, 100 ns units) derived from the absolute
+	// deadline, which also works for high-resolution timers.
+	LARGE_INTEGER due{};
+	due.QuadPart = -static_cast<LONGLONG>((deadline - now + 99) / 100);
+	if (!SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+		return wakeFor(WaitForMultipleObjects(2, handles, FALSE, static_cast<DWORD>((deadline - now) / kNsPerMs)));
+	}
+	const Wake w = wakeFor(WaitForMultipleObjects(3, handles, FALSE, INFINITE));
+	if (w != Wake::Deadline) CancelWaitableTimer(timer);
+	return w;
+}
+
+void Sampler::Impl::tick(std::uint64_t deadline) {
+	Sample& s = last;
+	s.wallNs = wallClockNs();
+	s.monoNs = monotonicNs();
+	jitter.record(s.wallNs > deadline ? s.wallNs - deadline : 0);
+
+	const std::uint64_t now = std::max(s.wallNs, deadline);
+	++s.seq;
+	s.cpuFresh = false;
+	s.memFresh = false;
+	s.freqFresh = false;
+	s.cgroupFresh = false;
+	s.deviceFresh = false;
+	s.streamTick = false;
+	// Both PDH collectors read this one collect when queries are batched.
+	if (freqDue <= now || memDue <= now) {
+		ifBuiltWith<collect::Freq, collect::MemPressure>(pdh, [this](auto& q) {
+			if (batch) q.collect();
+		});
+	}
+	if (cpuDue <= now) {
+		ifBuiltWith<collect::Cpu>(cpuMon, [&](auto& mon) { s.cpuPeriodMs = collectCpu(mon, cpuRate, cfg, s); });
+		cpuDue = ceilTo(std::max(cpuDue + s.cpuPeriodMs * kNsPerMs, now + 1), gridNs);
+	}
+	if (memDue <= now) {
+		s.memPeriodMs = collectMem(memRate, cfg, s);
+		ifBuiltWith<collect::MemPressure>(memPressureMon, [&](auto& mon) { mon.sample(s.memPressure); });
+		memDue = ceilTo(std::max(memDue + s.memPeriodMs * kNsPerMs, now + 1), gridNs);
+	}
+	const std::uint64_t baseNs = cfg.basePeriodMs * kNsPerMs;
+	if (freqDue <= now) {
+		ifBuiltWith<collect::Freq>(freqMon, [&](auto& mon) { s.freqFresh = mon.sample(s.freq); });
+		freqDue = ceilTo(std::max(freqDue + cfg.freqPeriodMs * kNsPerMs, now + 1), gridNs);
+	}
+	if (cgroupDue <= now) {
+		ifBuiltWith<collect::Cgroup>(cgroupMon, [&](auto& mon) {
+			if (!haveCgroups) return;
+			auto groups = cgroupLists.acquire();
+			s.cgroupFresh = mon.sample(*groups);
+			s.cgroups = std::move(groups);
+		});
+		cgroupDue = ceilTo(std::max(cgroupDue + cfg.cgroupPeriodMs * kNsPerMs, now + 1), gridNs);
+	}
+	if (deviceDue <= now) {
+		if (netRequest) {
+			SetEvent(netRequest); // the report follows via refreshDevice()
+		} else {
+			device = deviceCollector.collect();
+			s.deviceFresh = true;
+		}
+		deviceDue = ceilTo(std::max(deviceDue + cfg.devicePeriodMs * kNsPerMs, now + 1), baseNs);
+	}
+	if (streamDue <= now) {
+		s.streamTick = true;
+		streamDue = ceilTo(std::max(streamDue + baseNs, now + 1), baseNs);
+	}
+
+	publish();
+	if (!warm) warmUp();
+}
+
+// Off-schedule publish of a new device report, e.g. once a startup probe
+// has delivered a name. Carries the previous metrics with their fresh flags
+// cleared and does not move any collector's deadline.
+void Sampler::Impl::refreshDevice() {
+	Sample& s = last;
+	s.wallNs = wallClockNs();
+	s.monoNs = monotonicNs();
+	++s.seq;
+	s.cpuFresh = false;
+	s.memFresh = false;
+	s.freqFresh = false;
+	s.cgroupFresh = false;
+	s.streamTick = false;
+	device = deviceCollector.collect();
+	s.deviceFresh = true;
+	publish();
+}
+
+void Sampler::Impl::publish() {
+	auto snap = snapshots.acquire();
+	snap->sample = last;
+	snap->device = device;
+	store.publish(std::move(snap));
+
+	if (!onTick) return;
+	try {
+		onTick(last);
+	} catch (const std::exception& e) {
+		std::cerr << "Exception in sampler tick: " << e.what() << "\n";
+	} catch (...) {
+		std::cerr << "Unknown exception in sampler tick.\n";
+	}
+}
+
+// The first tick runs every collector, so its Sample has the steady-state
+// shape (core count, thermal zones, cgroup paths). Copying it into the idle
+// pool slots grows their vectors and strings once; from here on the tick
+// only reuses capacity, which the allocation guard then enforces.
+void Sampler::Impl::warmUp() {
+	snapshots.forEachIdle([this](Snapshot& slot) {
+		slot.sample = last;
+		slot.sample.cgroups.reset(); // would pin a cgroup list slot
+	});
+	if (last.cgroups) {
+		cgroupLists.forEachIdle([this](std::vector<CgroupUsage>& slot) { slot = *last.cgroups; });
+	}
+	warm = true;
+	allocGuardArmThisThread();
+}
+
+bool Sampler::start(const SamplerConfig& cfg) {
+	if (!_impl || _impl->thread || !_impl->refreshEvent) return false;
+
+	_impl->cfg = cfg;
+	if (_impl->cfg.basePeriodMs == 0) _impl->cfg.basePeriodMs = 1000;
+	if (_impl->cfg.devicePeriodMs == 0) _impl->cfg.devicePeriodMs = 15000;
+	if (_impl->cfg.freqPeriodMs == 0) _impl->cfg.freqPeriodMs = 2000;
+	if (_impl->cfg.cgroupPeriodMs == 0) _impl->cfg.cgroupPeriodMs = 2000;
+	// Batched collectors only ever run on base boundaries, so never ask for more.
+	if (_impl->cfg.batchQueries) _impl->cfg.rate.minPeriodMs = std::max(_impl->cfg.rate.minPeriodMs, _impl->cfg.basePeriodMs);
+	const std::uint32_t gridMs = _impl->cfg.adaptive && !_impl->cfg.batchQueries
+		? std::max<std::uint32_t>(1, _impl->cfg.rate.minPeriodMs)
+		: _impl->cfg.basePeriodMs;
+	_impl->gridNs = gridMs * kNsPerMs;
+	_impl->cpuRate = AdaptiveRate(_impl->cfg.rate, _impl->cfg.basePeriodMs);
+	_impl->memRate = AdaptiveRate(_impl->cfg.rate, _impl->cfg.basePeriodMs);
+	_impl->last = Sample{};
+	_impl->warm = false;
+	_impl->last.cpuPeriodMs = _impl->cfg.basePeriodMs;
+	_impl->last.memPeriodMs = _impl->cfg.basePeriodMs;
+
+	_impl->timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (!_impl->timer) _impl->timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	_impl->stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!_impl->timer || !_impl->stopEvent) {
+		if (_impl->timer) CloseHandle(_impl->timer);
+		if (_impl->stopEvent) CloseHandle(_impl->stopEvent);
+		_impl->timer = nullptr;
+		_impl->stopEvent = nullptr;
+		return false;
+	}
+
+	// Publishes a device report as soon as the thread is up instead of at the
+	// first deadline; names still pending show as placeholders.
+	if (_impl->refreshEvent) SetEvent(_impl->refreshEvent);
+	_impl->thread = CreateThread(nullptr, 0, [](LPVOID p) -> DWORD {
+		auto* impl = reinterpret_cast<Impl*>(p);
+		applyThreadPolicy(impl->cfg.thread);
+		impl->initCollectors();
+		impl->schedule(wallClockNs());
+		const std::uint64_t maxAheadNs = 2ULL * std::max(impl->cfg.basePeriodMs, impl->cfg.rate.maxPeriodMs) * kNsPerMs;
+		for (;;) {
+			std::uint64_t deadline = std::min({ impl->cpuDue, impl->memDue, impl->streamDue, impl->deviceDue, impl->freqDue, impl->cgroupDue });
+			// The wall clock was stepped backwards: rebuild the schedule from now.
+			if (deadline > wallClockNs() + maxAheadNs) {
+				impl->schedule(wallClockNs());
+				continue;
+			}
+			const Impl::Wake w = impl->waitUntil(deadline);
+			if (w == Impl::Wake::Stop) break;
+			if (w == Impl::Wake::Refresh) {
+				impl->refreshDevice();
+				continue;
+			}
+			impl->tick(deadline);
+		}
+		allocGuardDisarmThisThread();
+		return 0;
+	}, _impl, 0, nullptr);
+	if (!_impl->thread) {
+		CloseHandle(_impl->timer);
+		CloseHandle(_impl->stopEvent);
+		_impl->timer = nullptr;
+		_impl->stopEvent = nullptr;
+		return false;
+	}
+	if constexpr (kBuiltWith<collect::Network>) _impl->startNetProbe();
+	return true;
+}
+
+// Without the probe thread the device report simply carries no addresses;
+// the tick falls back to collecting it inline.
+void Sampler::Impl::startNetProbe() {
+	netRequest = CreateEventW(nullptr, FALSE, TRUE, nullptr); // first probe right away
+	if (!netRequest) return;
+	netThread = CreateThread(nullptr, 0, [](LPVOID p) -> DWORD {
+		auto* impl = reinterpret_cast<Impl*>(p);
+		applyThreadPolicy(impl->cfg.thread);
+		HANDLE handles[2] = { impl->stopEvent, impl->netRequest };
+		while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+			impl->deviceCollector.probeNetwork();
+			SetEvent(impl->refreshEvent);
+		}
+		return 0;
+	}, this, 0, nullptr);
+	if (!netThread) {
+		CloseHandle(netRequest);
+		netRequest = nullptr;
+	}
+}
+
+void Sampler::stop() noexcept {
+	if (!_impl || !_impl->thread) return;
+
+	SetEvent(_impl->stopEvent);
+	WaitForSingleObject(_impl->thread, INFINITE);
+	if (_impl->netThread) {
+		WaitForSingleObject(_impl->netThread, INFINITE);
+		CloseHandle(_impl->netThread);
+		CloseHandle(_impl->netRequest);
+		_impl->netThread = nullptr;
+		_impl->netRequest = nullptr;
+	}
+	CloseHandle(_impl->thread);
+	CloseHandle(_impl->timer);
+	CloseHandle(_impl->stopEvent);
+	_impl->thread = nullptr;
+	_impl->timer = nullptr;
+	_impl->stopEvent = nullptr;
+}
+
+} // namespace sysmon
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "sys_adaptive.h"
+#include "sys_alert.h"
+#include "sys_clock.h"
+#include "sys_sample.h"
+#include "sys_snapshot.h"
+#include "sys_thread_policy.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace sysmon {
+
+struct SamplerConfig {
+	std::uint32_t basePeriodMs{ 1000 };
+	std::uint32_t devicePeriodMs{ 15000 };
+	std::uint32_t freqPeriodMs{ 2000 };
+	std::uint32_t cgroupPeriodMs{ 2000 };
+	bool adaptive{ true };
+	AdaptiveRateConfig rate;
+	// Values past these count as approaching an alert threshold and speed
+	// sampling up. The defaults suit defaultAlertRules(); use
+	// watchAlertRules() to follow a custom rule set.
+	double cpuWatchPercent{ 85.0 };
+	double memWatchAvailPercent{ 10.0 };
+	// Applied to the sampler thread before it opens any query.
+	ThreadPolicy thread;
+	// Low-perturbation mode: every collector runs on basePeriodMs boundaries
+	// (adaptive rates only ever slow down to multiples of it), so each period
+	// costs one wake-up with all OS queries in a single burst, and the PDH
+	// collectors share one query collected once per tick.
+	bool batchQueries{};
+};
+
+// Sets the watch levels a fixed margin short of the nearest threshold in
+// `rules`: 10 points below the lowest CPU "above" threshold and 5 points
+// above the highest available-RAM "below" threshold. A metric no rule
+// watches never speeds sampling up.
+void watchAlertRules(SamplerConfig& cfg, const std::vector<AlertRule>& rules);
+
+// Owns the only thread that samples anything: whenever a collector is due
+// it builds a Sample, publishes an immutable Snapshot and then hands the
+// Sample to the tick handler on that thread. Wake-ups are
+// scheduled on absolute wall-clock deadlines (multiples of the period), so
+// collection time never accumulates into drift.
+class Sampler {
+public:
+	using TickHandler = std::function<void(const Sample&)>;
+
+	explicit Sampler(TickHandler onTick);
+	~Sampler();
+
+	Sampler(const Sampler&) = delete;
+	Sampler& operator=(const Sampler&) = delete;
+
+	bool start(const SamplerConfig& cfg);
+	void stop() noexcept;
+
+	// Any thread, before or after start(). Hands a startup probe result to the
+	// device collector and republishes the device report without waiting for
+	// the next deadline.
+	void setDeviceName(DeviceName which, const std::wstring& name);
+
+	const JitterHistogram& jitter() const;
+	// Latest published snapshot, or null before the first tick. Any thread.
+	std::shared_ptr<const Snapshot> latest() const;
+
+private:
+	struct Impl;
+	Impl* _impl;
+};
+
+} // namespace sysmon
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "sys_device.h"
+#include "sys_sample.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace sysmon {
+
+// Everything a reader needs for one tick. Built by the sampler thread and
+// never modified after publication, so readers need no locking.
+struct Snapshot {
+	Sample sample;
+	std::shared_ptr<const DeviceReport> device;
+};
+
+// Single-writer, many-reader publication point (RCU style): the writer swaps
+// in a new immutable snapshot, readers keep whatever version they loaded
+// alive through the shared_ptr for as long as they use it.
+class SnapshotStore {
+public:
+	void publish(std::shared_ptr<const Snapshot> snap) {
+		std::atomic_store_explicit(&_latest, std::move(snap), std::memory_order_release);
+	}
+
+	std::shared_ptr<const Snapshot> latest() const {
+		return std::atomic_load_explicit(&_latest, std::memory_order_acquire);
+	}
+
+private:
+	std::shared_ptr<const Snapshot> _latest;
+};
+
+} // namespace sysmon
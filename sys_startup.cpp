@@ -0,0 +1,62 @@
+#include "sys_startup.h"
+
+#include "sys_alloc_guard.h"
+#include "sys_clock.h"
+
+#include <windows.h>
+
+#include <cstdio>
+#include <iostream>
+
+namespace sysmon {
+
+static const char* const kPhaseNames[] = {
+	"window_created",
+	"first_paint",
+	"cpu_name",
+	"gpu_name",
+	"first_device",
+	"first_sample",
+	"data_complete",
+};
+static_assert(sizeof(kPhaseNames) / sizeof(kPhaseNames[0]) == static_cast<std::size_t>(StartupPhase::Count), "one name per phase");
+
+void StartupTimeline::begin() {
+	_beginNs = monotonicNs();
+}
+
+bool StartupTimeline::reached(StartupPhase phase) const {
+	return _atNs[static_cast<std::size_t>(phase)].load(std::memory_order_acquire) != 0;
+}
+
+void StartupTimeline::mark(StartupPhase phase) {
+	const std::size_t i = static_cast<std::size_t>(phase);
+	// +1 keeps a phase reached at exactly begin() distinguishable from "not yet".
+	const std::uint64_t at = monotonicNs() - _beginNs + 1;
+	std::uint64_t expected = 0;
+	if (!_atNs[i].compare_exchange_strong(expected, at, std::memory_order_acq_rel)) return;
+
+	AllocGuardExempt exempt; // runs once per phase, possibly on an armed thread
+	char buf[64];
+	std::snprintf(buf, sizeof(buf), "Startup: %s +%.1f ms\n", kPhaseNames[i], static_cast<double>(at - 1) / 1e6);
+	// A /SUBSYSTEM:WINDOWS process has no console: the debugger output
+	// (DebugView, or the IDE's Output window) is where these are seen live.
+	// stdout still gets a copy for runs that redirect it.
+	OutputDebugStringA(buf);
+	std::cout << buf;
+}
+
+std::string StartupTimeline::format() const {
+	std::string out = "STARTUP";
+	char buf[64];
+	for (std::size_t i = 0; i < kPhases; ++i) {
+		const std::uint64_t at = _atNs[i].load(std::memory_order_acquire);
+		if (at) std::snprintf(buf, sizeof(buf), " %s_ms=%.1f", kPhaseNames[i], static_cast<double>(at - 1) / 1e6);
+		else std::snprintf(buf, sizeof(buf), " %s_ms=-1", kPhaseNames[i]);
+		out += buf;
+	}
+	out += "\r\n";
+	return out;
+}
+
+} // namespace sysmon
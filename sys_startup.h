@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sysmon {
+
+enum class StartupPhase {
+	WindowCreated, // controls and tray icon exist
+	FirstPaint,    // first WM_ERASEBKGND, placeholders visible
+	CpuName,       // registry probe finished
+	GpuName,       // DXGI probe finished
+	FirstDevice,   // first device report shown (network, RAM)
+	FirstSample,   // first collector tick delivered
+	DataComplete,  // a sample arrived and the shown report has no placeholders left
+	Count,
+};
+
+// Time of each startup phase relative to begin(), for tracking
+// time-to-first-paint and time-to-complete-data. Each phase is recorded
+// (and logged) only the first time it is marked; any thread may mark.
+class StartupTimeline {
+public:
+	void begin();
+	void mark(StartupPhase phase);
+	bool reached(StartupPhase phase) const;
+
+	// "STARTUP window_created_ms=.. first_paint_ms=.. ..." (-1 when not reached).
+	std::string format() const;
+
+private:
+	static constexpr std::size_t kPhases = static_cast<std::size_t>(StartupPhase::Count);
+
+	std::uint64_t _beginNs{};
+	std::atomic<std::uint64_t> _atNs[kPhases]{};
+};
+
+} // namespace sysmon
@@ -0,0 +1,73 @@
+#include "sys_thread_policy.h"
+
+#include <windows.h>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace sysmon {
+
+bool applyThreadPolicy(const ThreadPolicy& policy) {
+	bool ok = true;
+	HANDLE self = GetCurrentThread();
+	if (policy.affinityMask) {
+		if (!SetThreadAffinityMask(self, static_cast<DWORD_PTR>(policy.affinityMask))) {
+			std::cerr << "SetThreadAffinityMask failed: " << GetLastError() << "\n";
+			ok = false;
+		}
+	}
+	if (policy.background) {
+		// Background mode lowers I/O and memory priority as well; the idle
+		// CPU priority set afterwards is the lowest a normal thread can have.
+		if (!SetThreadPriority(self, THREAD_MODE_BACKGROUND_BEGIN) || !SetThreadPriority(self, THREAD_PRIORITY_IDLE)) {
+			std::cerr << "SetThreadPriority failed: " << GetLastError() << "\n";
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+bool applyProcessPolicy(const ThreadPolicy& policy) {
+	bool ok = true;
+	HANDLE self = GetCurrentProcess();
+	if (policy.affinityMask) {
+		if (!SetProcessAffinityMask(self, static_cast<DWORD_PTR>(policy.affinityMask))) {
+			std::cerr << "SetProcessAffinityMask failed: " << GetLastError() << "\n";
+			ok = false;
+		}
+	}
+	if (policy.background) {
+		if (!SetPriorityClass(self, PROCESS_MODE_BACKGROUND_BEGIN) || !SetPriorityClass(self, IDLE_PRIORITY_CLASS)) {
+			std::cerr << "SetPriorityClass failed: " << GetLastError() << "\n";
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+bool parseCoreSet(const std::string& spec, std::uint64_t& mask) {
+	std::uint64_t out = 0;
+	const char* p = spec.c_str();
+	for (;;) {
+		char* end = nullptr;
+		const unsigned long first = std::strtoul(p, &end, 10);
+		if (end == p) return false;
+		unsigned long last = first;
+		p = end;
+		if (*p == '-') {
+			++p;
+			last = std::strtoul(p, &end, 10);
+			if (end == p) return false;
+			p = end;
+		}
+		if (last < first || last > 63) return false;
+		for (unsigned long i = first; i <= last; ++i) out |= 1ULL << i;
+		if (*p == '\0') break;
+		if (*p != ',') return false;
+		++p;
+	}
+	mask = out;
+	return out != 0;
+}
+
+} // namespace sysmon
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace sysmon {
+
+// Placement for the monitor's own threads on hosts whose other cores must
+// not be disturbed: pin them to a housekeeping core set and let them run
+// only when nothing else wants the CPU. Both default to "leave as is".
+struct ThreadPolicy {
+	// Bit i = logical processor i of the first processor group; 0 = any.
+	std::uint64_t affinityMask{};
+	// Idle CPU priority plus background I/O and memory priority. On a fully
+	// loaded housekeeping set the thread can be delayed by whole quanta,
+	// which shows up in STATS JITTER.
+	bool background{};
+};
+
+// Applies the policy to the calling thread; logs and returns false if the
+// OS refused any part (e.g. a mask outside the process affinity).
+bool applyThreadPolicy(const ThreadPolicy& policy);
+
+// The same for the whole process (affinity mask, background mode and idle
+// priority class), so threads that apply no policy of their own, such as
+// the UI thread and the startup probes, stay off the other cores too.
+bool applyProcessPolicy(const ThreadPolicy& policy);
+
+// Parses "0,2,4-7" into a mask. Rejects empty sets and cores past 63.
+bool parseCoreSet(const std::string& spec, std::uint64_t& mask);
+
+} // namespace sysmon
@@ -0,0 +1,88 @@
+#include "sys_worker_pool.h"
+
+#include <windows.h>
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace sysmon {
+
+struct WorkerPool::Impl {
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<std::function<void()>> jobs;
+	bool stopping{};
+	std::vector<HANDLE> threads;
+
+	void work();
+};
+
+void WorkerPool::Impl::work() {
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (stopping) return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		try {
+			job();
+		} catch (const std::exception& e) {
+			std::cerr << "Exception in worker job: " << e.what() << "\n";
+		} catch (...) {
+			std::cerr << "Unknown exception in worker job.\n";
+		}
+	}
+}
+
+WorkerPool::WorkerPool(std::size_t threads) : _impl(new Impl{}) {
+	if (threads == 0) threads = 1;
+	for (std::size_t i = 0; i < threads; ++i) {
+		HANDLE h = CreateThread(nullptr, 0, [](LPVOID p) -> DWORD {
+			reinterpret_cast<Impl*>(p)->work();
+			return 0;
+		}, _impl, 0, nullptr);
+		if (h) _impl->threads.push_back(h);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	shutdown();
+	delete _impl;
+	_impl = nullptr;
+}
+
+bool WorkerPool::submit(std::function<void()> job) {
+	if (!_impl) return false;
+	{
+		std::lock_guard<std::mutex> lock(_impl->mutex);
+		if (_impl->stopping || _impl->threads.empty()) return false;
+		_impl->jobs.push_back(std::move(job));
+	}
+	_impl->cv.notify_one();
+	return true;
+}
+
+void WorkerPool::shutdown() noexcept {
+	if (!_impl) return;
+	{
+		std::lock_guard<std::mutex> lock(_impl->mutex);
+		if (_impl->stopping) return;
+		_impl->stopping = true;
+		_impl->jobs.clear();
+	}
+	_impl->cv.notify_all();
+	for (HANDLE h : _impl->threads) {
+		WaitForSingleObject(h, INFINITE);
+		CloseHandle(h);
+	}
+	_impl->threads.clear();
+}
+
+} // namespace sysmon
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace sysmon {
+
+// Small fixed set of threads for one-off blocking jobs (startup probes).
+// Jobs run in submission order across the threads; a job that throws is
+// logged and dropped.
+class WorkerPool {
+public:
+	explicit WorkerPool(std::size_t threads);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Returns false once shutdown() has started.
+	bool submit(std::function<void()> job);
+	// Drops jobs that have not started and waits for running ones to finish.
+	void shutdown() noexcept;
+
+private:
+	struct Impl;
+	Impl* _impl;
+};
+
+} // namespace sysmon
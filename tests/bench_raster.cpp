@@ -0,0 +1,80 @@
+// Per-frame cost of the tray window's sparkline repaint, before and after
+// the background cache:
+//   full    regenerate the whole gradient, then draw both sparklines
+//           (what every WM_SAMPLE cost when the background was redrawn)
+//   cached  restore only the two sparkline rectangles from the cached
+//           gradient, then draw the sparklines
+#include "ui_raster.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace sysmon;
+
+namespace {
+
+// Window and sparkline geometry of the tray app (ui_app.cpp).
+constexpr int kWidth = 420;
+constexpr int kHeight = 380;
+constexpr RasterRect kCpuRect{ 10, 268, 195, 328 };
+constexpr RasterRect kMemRect{ 205, 268, 390, 328 };
+constexpr std::size_t kPoints = 60;
+
+volatile std::uint32_t g_sink;
+
+template <class F>
+double nsPerFrame(int frames, F&& frame) {
+	const auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; ++i) frame(i);
+	const auto t1 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / frames;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const int frames = argc > 1 ? std::atoi(argv[1]) : 5000;
+
+	std::vector<std::uint32_t> bgPixels(kWidth * kHeight);
+	std::vector<std::uint32_t> framePixels(kWidth * kHeight);
+	Surface background{ bgPixels.data(), kWidth, kHeight, kWidth };
+	Surface frame{ framePixels.data(), kWidth, kHeight, kWidth };
+	const std::uint32_t top = packRgb(30, 60, 90);
+	const std::uint32_t bottom = packRgb(200, 220, 240);
+	fillVerticalGradient(background, top, bottom);
+
+	double cpu[kPoints];
+	double mem[kPoints];
+	auto series = [&](int f) {
+		for (std::size_t i = 0; i < kPoints; ++i) {
+			cpu[i] = 50.0 + 45.0 * std::sin(0.2 * static_cast<double>(i + f));
+			mem[i] = 60.0 + 10.0 * std::cos(0.1 * static_cast<double>(i + f));
+		}
+	};
+	auto sparklines = [&] {
+		drawSparkline(frame, kCpuRect, cpu, kPoints, 0.0, 100.0, packRgb(255, 80, 80));
+		drawSparkline(frame, kMemRect, mem, kPoints, 0.0, 100.0, packRgb(80, 160, 255));
+	};
+
+	const double full = nsPerFrame(frames, [&](int f) {
+		series(f);
+		fillVerticalGradient(frame, top, bottom);
+		sparklines();
+		g_sink = frame.pixels[f % (kWidth * kHeight)];
+	});
+	const double cached = nsPerFrame(frames, [&](int f) {
+		series(f);
+		copyRect(background, frame, kCpuRect);
+		copyRect(background, frame, kMemRect);
+		sparklines();
+		g_sink = frame.pixels[f % (kWidth * kHeight)];
+	});
+
+	std::printf("frames=%d surface=%dx%d\n", frames, kWidth, kHeight);
+	std::printf("full   %10.0f ns/frame\n", full);
+	std::printf("cached %10.0f ns/frame (%.1fx)\n", cached, cached > 0 ? full / cached : 0.0);
+	return 0;
+}
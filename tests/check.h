@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertion helpers: a failed CHECK is reported and counted, and
+// the test's main() returns checkResult().
+
+inline int& checkFailures() {
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(cond)                                                                     \
+	do {                                                                                \
+		if (!(cond)) {                                                                  \
+			std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+			++checkFailures();                                                          \
+		}                                                                               \
+	} while (0)
+
+inline int checkResult() {
+	if (checkFailures()) std::fprintf(stderr, "%d check(s) failed\n", checkFailures());
+	return checkFailures() ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#include "sys_adaptive.h"
+
+#include "check.h"
+
+using namespace sysmon;
+
+namespace {
+
+AdaptiveRateConfig config(std::uint32_t minMs, std::uint32_t maxMs) {
+	AdaptiveRateConfig cfg;
+	cfg.minPeriodMs = minMs;
+	cfg.maxPeriodMs = maxMs;
+	return cfg;
+}
+
+// Flat needs a full window of deltas; until then the period stays put.
+void testSlowsWhenFlat() {
+	AdaptiveRate rate(config(250, 5000), 1000);
+	for (int i = 0; i < 8; ++i) CHECK(rate.update(20.0, false) == 1000);
+	CHECK(rate.update(20.0, false) == 1500);
+	CHECK(rate.update(20.1, false) == 2250);
+	CHECK(rate.update(20.0, false) == 3375);
+	CHECK(rate.update(20.0, false) == 5000); // clamped to max
+	CHECK(rate.update(20.0, false) == 5000);
+}
+
+void testSpeedsUpOnVariance() {
+	AdaptiveRate rate(config(250, 5000), 4000);
+	rate.update(10.0, false);
+	rate.update(40.0, false);
+	CHECK(rate.periodMs() == 4000); // one delta: no spread yet
+	CHECK(rate.update(5.0, false) == 2000);
+	CHECK(rate.update(60.0, false) == 1000);
+	CHECK(rate.update(0.0, false) == 500);
+	CHECK(rate.update(90.0, false) == 250);
+	CHECK(rate.update(10.0, false) == 250); // clamped to min
+}
+
+void testSpeedsUpNearThreshold() {
+	AdaptiveRate rate(config(250, 5000), 2000);
+	CHECK(rate.update(50.0, true) == 1000);
+	CHECK(rate.update(50.0, true) == 500);
+	// Flat but still near the threshold: no slowing down.
+	for (int i = 0; i < 10; ++i) rate.update(50.0, true);
+	CHECK(rate.periodMs() == 250);
+	// Once it leaves the threshold behind, a flat window slows it again.
+	CHECK(rate.update(50.0, false) > 250);
+}
+
+void testClamps() {
+	AdaptiveRate high(config(250, 5000), 60000);
+	CHECK(high.periodMs() == 5000);
+	AdaptiveRate low(config(250, 5000), 10);
+	CHECK(low.periodMs() == 250);
+	AdaptiveRate inverted(config(500, 100), 1000);
+	CHECK(inverted.periodMs() == 500);
+	AdaptiveRate zeroMin(config(0, 100), 0);
+	CHECK(zeroMin.periodMs() == 1);
+}
+
+// A 1 ms floor used to be stuck: 1 + 1 / 2 == 1.
+void testGrowsFromOneMs() {
+	AdaptiveRate rate(config(1, 10), 1);
+	for (int i = 0; i < 8; ++i) rate.update(0.0, false);
+	CHECK(rate.update(0.0, false) == 2);
+	CHECK(rate.update(0.0, false) == 3);
+	CHECK(rate.update(0.0, false) == 4);
+	CHECK(rate.update(0.0, false) == 6);
+	CHECK(rate.update(0.0, false) == 9);
+	CHECK(rate.update(0.0, false) == 10);
+}
+
+} // namespace
+
+int main() {
+	testSlowsWhenFlat();
+	testSpeedsUpOnVariance();
+	testSpeedsUpNearThreshold();
+	testClamps();
+	testGrowsFromOneMs();
+	return checkResult();
+}
@@ -0,0 +1,166 @@
+#include "sys_alert.h"
+
+#include "check.h"
+
+#include <vector>
+
+using namespace sysmon;
+
+namespace {
+
+AlertRule rule(AlertMetric metric, AlertCompare compare, double threshold, double clear, std::uint32_t sustain) {
+	AlertRule r;
+	r.name = "test";
+	r.metric = metric;
+	r.compare = compare;
+	r.threshold = threshold;
+	r.clearThreshold = clear;
+	r.sustainSamples = sustain;
+	return r;
+}
+
+Sample cpuSample(double pct, bool fresh = true) {
+	Sample s;
+	s.cpuPercent = { true, pct };
+	s.cpuFresh = fresh;
+	return s;
+}
+
+Sample coreSample(std::vector<double> cores) {
+	Sample s;
+	s.corePercent = std::move(cores);
+	s.cpuFresh = true;
+	return s;
+}
+
+Sample memSample(double availPct) {
+	Sample s;
+	s.mem = { 1000, static_cast<std::uint64_t>(availPct * 10.0), true };
+	s.memFresh = true;
+	return s;
+}
+
+void testSustain() {
+	AlertEngine engine;
+	engine.setRules({ rule(AlertMetric::CpuTotalPercent, AlertCompare::Above, 90.0, 80.0, 3) });
+	std::vector<AlertEvent> ev;
+	engine.evaluate(cpuSample(95.0), ev);
+	engine.evaluate(cpuSample(95.0), ev);
+	CHECK(ev.empty());
+	// A dip below the threshold restarts the streak.
+	engine.evaluate(cpuSample(50.0), ev);
+	engine.evaluate(cpuSample(95.0), ev);
+	engine.evaluate(cpuSample(95.0), ev);
+	CHECK(ev.empty());
+	engine.evaluate(cpuSample(96.0), ev);
+	CHECK(ev.size() == 1 && ev[0].raised && ev[0].channel == -1 && ev[0].value == 96.0);
+	CHECK(formatAlertLine(ev[0]) == "ALERT RAISE test value=96.0\r\n");
+
+	// Still above: no second raise.
+	ev.clear();
+	engine.evaluate(cpuSample(99.0), ev);
+	CHECK(ev.empty());
+}
+
+void testHysteresis() {
+	AlertEngine engine;
+	engine.setRules({ rule(AlertMetric::CpuTotalPercent, AlertCompare::Above, 90.0, 80.0, 1) });
+	std::vector<AlertEvent> ev;
+	engine.evaluate(cpuSample(91.0), ev);
+	CHECK(ev.size() == 1 && ev[0].raised);
+
+	// Between clearThreshold and threshold the alert holds.
+	ev.clear();
+	engine.evaluate(cpuSample(85.0), ev);
+	engine.evaluate(cpuSample(80.5), ev);
+	CHECK(ev.empty());
+	std::vector<AlertEvent> act;
+	engine.active(act);
+	CHECK(act.size() == 1 && act[0].value == 80.5);
+
+	engine.evaluate(cpuSample(79.0), ev);
+	CHECK(ev.size() == 1 && !ev[0].raised && ev[0].value == 79.0);
+	act.clear();
+	engine.active(act);
+	CHECK(act.empty());
+}
+
+void testBelow() {
+	AlertEngine engine;
+	engine.setRules({ rule(AlertMetric::MemAvailPercent, AlertCompare::Below, 5.0, 7.0, 2) });
+	std::vector<AlertEvent> ev;
+	engine.evaluate(memSample(4.0), ev);
+	engine.evaluate(memSample(3.0), ev);
+	CHECK(ev.size() == 1 && ev[0].raised);
+	engine.evaluate(memSample(6.0), ev);
+	CHECK(ev.size() == 1);
+	engine.evaluate(memSample(7.5), ev);
+	CHECK(ev.size() == 2 && !ev[1].raised);
+}
+
+// A collector that did not run this tick carries its old value; that must
+// not count towards the sustain streak (or clear an alert).
+void testStaleSamples() {
+	AlertEngine engine;
+	engine.setRules({ rule(AlertMetric::CpuTotalPercent, AlertCompare::Above, 90.0, 80.0, 2) });
+	std::vector<AlertEvent> ev;
+	engine.evaluate(cpuSample(95.0), ev);
+	engine.evaluate(cpuSample(95.0, false), ev);
+	engine.evaluate(cpuSample(95.0, false), ev);
+	CHECK(ev.empty());
+	engine.evaluate(cpuSample(95.0), ev);
+	CHECK(ev.size() == 1 && ev[0].raised);
+	engine.evaluate(cpuSample(10.0, false), ev);
+	CHECK(ev.size() == 1);
+}
+
+void testPerCore() {
+	AlertEngine engine;
+	engine.setRules({ rule(AlertMetric::CpuCorePercent, AlertCompare::Above, 90.0, 80.0, 1) });
+	std::vector<AlertEvent> ev;
+	engine.evaluate(coreSample({ 10.0, 95.0 }), ev);
+	CHECK(ev.size() == 1 && ev[0].channel == 1);
+	CHECK(formatAlertLine(ev[0]) == "ALERT RAISE test core=1 value=95.0\r\n");
+
+	// More cores: the new channels start idle, the old ones keep state.
+	ev.clear();
+	engine.evaluate(coreSample({ 10.0, 85.0, 50.0, 99.0 }), ev);
+	CHECK(ev.size() == 1 && ev[0].channel == 3 && ev[0].raised);
+	std::vector<AlertEvent> act;
+	engine.active(act);
+	CHECK(act.size() == 2);
+
+	// Fewer cores: the dropped channels' state goes with them.
+	ev.clear();
+	engine.evaluate(coreSample({ 10.0 }), ev);
+	CHECK(ev.empty());
+	act.clear();
+	engine.active(act);
+	CHECK(act.empty());
+	engine.evaluate(coreSample({ 10.0, 85.0 }), ev);
+	CHECK(ev.empty()); // channel 1 restarted inactive; 85 is below the trip
+}
+
+void testRulesReset() {
+	AlertEngine engine;
+	engine.setRules({ rule(AlertMetric::CpuTotalPercent, AlertCompare::Above, 90.0, 80.0, 0) });
+	std::vector<AlertEvent> ev;
+	engine.evaluate(cpuSample(95.0), ev); // sustain 0 behaves as 1
+	CHECK(ev.size() == 1);
+	engine.setRules(defaultAlertRules());
+	std::vector<AlertEvent> act;
+	engine.active(act);
+	CHECK(act.empty());
+}
+
+} // namespace
+
+int main() {
+	testSustain();
+	testHysteresis();
+	testBelow();
+	testStaleSamples();
+	testPerCore();
+	testRulesReset();
+	return checkResult();
+}
@@ -0,0 +1,155 @@
+#include "sys_cgroup.h"
+
+#include "check.h"
+
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#endif
+
+using namespace sysmon;
+
+namespace {
+
+void testFindMount() {
+	const char* unifiedOnly =
+		"22 1 0:21 / /proc rw,nosuid - proc proc rw\n"
+		"35 24 0:30 / /sys/fs/cgroup rw,nosuid,nodev,noexec shared:9 - cgroup2 cgroup2 rw,nsdelegate\n";
+	CHECK(findCgroup2Mount(unifiedOnly) == "/sys/fs/cgroup");
+
+	// Hybrid: v1 controllers under /sys/fs/cgroup, v2 beside them.
+	const char* hybrid =
+		"25 24 0:23 / /sys/fs/cgroup ro,nosuid shared:9 - tmpfs tmpfs ro,mode=755\n"
+		"26 25 0:24 / /sys/fs/cgroup/unified rw,nosuid shared:10 - cgroup2 cgroup2 rw,nsdelegate\n"
+		"27 25 0:25 / /sys/fs/cgroup/cpu,cpuacct rw shared:11 - cgroup cgroup rw,cpu,cpuacct\n";
+	CHECK(findCgroup2Mount(hybrid) == "/sys/fs/cgroup/unified");
+
+	// A v1 "cgroup" mount is not a match, and neither is a mount point
+	// named like the filesystem type.
+	const char* v1Only =
+		"27 25 0:25 / /sys/fs/cgroup/cpu rw shared:11 - cgroup cgroup rw,cpu\n"
+		"28 25 0:26 / /mnt/cgroup2 rw - ext4 /dev/sda1 rw";
+	CHECK(findCgroup2Mount(v1Only).empty());
+	CHECK(findCgroup2Mount("").empty());
+
+	// Spaces in the mount point are escaped as \040; no trailing newline.
+	CHECK(findCgroup2Mount("40 1 0:40 / /mnt/my\\040cg rw - cgroup2 none rw") == "/mnt/my cg");
+}
+
+CgroupUsage usage(const char* path, double cpu, std::uint64_t mem) {
+	CgroupUsage u;
+	u.path = path;
+	u.cpuPercent = cpu;
+	u.memCurrentBytes = mem;
+	return u;
+}
+
+void testTop() {
+	std::vector<CgroupUsage> groups = { usage("/a", 5.0, 300), usage("/b", 50.0, 100), usage("/c", 20.0, 200) };
+	std::vector<CgroupUsage> byCpu = groups;
+	topCgroups(byCpu, CgroupSort::Cpu, 2);
+	CHECK(byCpu.size() == 2 && byCpu[0].path == "/b" && byCpu[1].path == "/c");
+
+	std::vector<CgroupUsage> byMem = groups;
+	topCgroups(byMem, CgroupSort::Memory, 10);
+	CHECK(byMem.size() == 3 && byMem[0].path == "/a" && byMem[2].path == "/b");
+
+	const std::string text = formatCgroupTop(groups, CgroupSort::Cpu, 1);
+	CHECK(text == "CGROUP /b cpu=50.0 mem=100 mem_max=0 io_r=0 io_w=0\r\n");
+	CHECK(formatCgroupTop({}, CgroupSort::Cpu, 8) == "CGROUP none\r\n");
+}
+
+#if defined(__linux__)
+
+void writeFile(const std::string& path, const std::string& text) {
+	if (FILE* f = std::fopen(path.c_str(), "w")) {
+		std::fputs(text.c_str(), f);
+		std::fclose(f);
+	}
+}
+
+void makeGroup(const std::string& dir, std::uint64_t usageUsec) {
+	mkdir(dir.c_str(), 0755);
+	writeFile(dir + "/cpu.stat", "usage_usec " + std::to_string(usageUsec) + "\nuser_usec 0\n");
+	writeFile(dir + "/memory.current", "4096\n");
+	writeFile(dir + "/memory.max", "max\n");
+	writeFile(dir + "/io.stat", "8:0 rbytes=100 wbytes=20 rios=1 wios=1\n8:16 rbytes=1 wbytes=2\n");
+}
+
+void removeGroup(const std::string& dir) {
+	for (const char* f : { "/cpu.stat", "/memory.current", "/memory.max", "/io.stat" }) unlink((dir + f).c_str());
+	rmdir(dir.c_str());
+}
+
+const CgroupUsage* find(const std::vector<CgroupUsage>& groups, const char* path) {
+	for (const auto& g : groups) {
+		if (g.path == path) return &g;
+	}
+	return nullptr;
+}
+
+// A fake hierarchy in a temp directory: the monitor only needs the files.
+void testMonitor() {
+	char tmpl[] = "/tmp/sysmon_cgroup_XXXXXX";
+	if (!mkdtemp(tmpl)) {
+		CHECK(!"mkdtemp failed");
+		return;
+	}
+	const std::string root = tmpl;
+	writeFile(root + "/cgroup.controllers", "cpu memory io\n");
+	writeFile(root + "/cpu.stat", "usage_usec 0\n");
+	makeGroup(root + "/app", 1000);
+
+	{
+		CgroupMonitor mon;
+		CHECK(mon.init(root.c_str()));
+		std::vector<CgroupUsage> groups;
+		CHECK(mon.sample(groups));
+		CHECK(groups.size() == 2);
+		const CgroupUsage* app = find(groups, "/app");
+		CHECK(app && app->cpuUsageUsec == 1000 && app->memCurrentBytes == 4096 && app->memMaxBytes == 0);
+		CHECK(app && app->ioReadBytes == 101 && app->ioWriteBytes == 22);
+
+		// Created after init: picked up from inotify on the next sample.
+		makeGroup(root + "/app/worker", 0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		writeFile(root + "/app/cpu.stat", "usage_usec 1000000000\n");
+		CHECK(mon.sample(groups));
+		CHECK(find(groups, "/app/worker") != nullptr);
+		app = find(groups, "/app");
+		CHECK(app && app->cpuPercent > 100.0);
+
+		removeGroup(root + "/app/worker");
+		CHECK(mon.sample(groups));
+		CHECK(groups.size() == 2 && find(groups, "/app/worker") == nullptr);
+	}
+
+	removeGroup(root + "/app");
+	unlink((root + "/cgroup.controllers").c_str());
+	unlink((root + "/cpu.stat").c_str());
+	rmdir(root.c_str());
+
+	CgroupMonitor missing;
+	CHECK(!missing.init("/nonexistent/cgroup"));
+}
+
+#endif
+
+} // namespace
+
+int main() {
+	testFindMount();
+	testTop();
+#if defined(__linux__)
+	testMonitor();
+#endif
+	return checkResult();
+}
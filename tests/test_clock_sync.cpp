@@ -0,0 +1,122 @@
+#include "clock_sync.h"
+
+#include "check.h"
+
+#include <string>
+
+using namespace sysmon;
+
+namespace {
+
+// The server clock runs kOffset ahead of the client's.
+constexpr std::int64_t kOffset = 1000000;
+
+// One exchange sent at client time t1, taking `out` / `back` ns each way
+// and `hold` ns on the server.
+PingExchange exchange(std::int64_t t1, std::int64_t out, std::int64_t back, std::int64_t hold = 50) {
+	PingExchange ex;
+	ex.t1 = t1;
+	ex.t2 = t1 + out + kOffset;
+	ex.t3 = ex.t2 + hold;
+	ex.t4 = ex.t3 - kOffset + back;
+	return ex;
+}
+
+void testParse() {
+	std::int64_t t1 = 0;
+	CHECK(parsePing("PING 123", t1) && t1 == 123);
+	CHECK(parsePing("PING -5 ", t1) && t1 == -5);
+	CHECK(!parsePing("PING", t1));
+	CHECK(!parsePing("PING ", t1));
+	CHECK(!parsePing("PING 12x", t1));
+	CHECK(!parsePing("PING 99999999999999999999", t1));
+	CHECK(!parsePing("PONG 1", t1));
+
+	std::string ping = formatPing(42);
+	CHECK(ping == "PING 42\r\n");
+	ping.resize(ping.size() - 2); // the server strips the terminator
+	CHECK(parsePing(ping, t1) && t1 == 42);
+
+	PingExchange ex;
+	CHECK(parsePong(formatPong(1, 2, 3), 4, ex));
+	CHECK(ex.t1 == 1 && ex.t2 == 2 && ex.t3 == 3 && ex.t4 == 4);
+	CHECK(parsePong("PONG -1 20 30", 40, ex) && ex.t1 == -1);
+	CHECK(!parsePong("PONG 1 2", 4, ex));
+	CHECK(!parsePong("PONG 1 2 3 4", 4, ex));
+	CHECK(!parsePong("PING 1 2 3", 4, ex));
+}
+
+void testKnownOffset() {
+	ClockSync sync;
+	std::int64_t client = 0;
+	CHECK(!sync.estimate().valid);
+	CHECK(!sync.serverToClient(5, client) && client == 0);
+
+	sync.add(exchange(0, 100, 100));
+	const ClockEstimate est = sync.estimate();
+	CHECK(est.valid);
+	CHECK(est.offsetNs == kOffset);
+	CHECK(est.delayNs == 200);
+	CHECK(est.jitterNs == 0);
+	CHECK(sync.serverToClient(kOffset + 777, client) && client == 777);
+}
+
+// Asymmetric paths bias the offset by half the difference; the filter
+// prefers the least-delayed exchange, which has the least bias.
+void testAsymmetric() {
+	ClockSync sync;
+	sync.add(exchange(0, 300, 100));
+	ClockEstimate est = sync.estimate();
+	CHECK(est.offsetNs == kOffset + 100);
+	CHECK(est.delayNs == 400);
+
+	sync.add(exchange(1000, 100, 100));
+	sync.add(exchange(2000, 100, 500));
+	est = sync.estimate();
+	CHECK(est.offsetNs == kOffset);
+	CHECK(est.delayNs == 200);
+	// sqrt((100^2 + 0^2 + 200^2) / 2)
+	CHECK(est.jitterNs == 158);
+}
+
+void testNegativeDelayRejected() {
+	ClockSync sync;
+	PingExchange stepped = exchange(0, 100, 100, 50);
+	stepped.t4 = stepped.t1 + 10; // client clock stepped back mid-exchange
+	sync.add(stepped);
+	CHECK(!sync.estimate().valid);
+
+	sync.add(exchange(0, 100, 100));
+	sync.add(stepped);
+	CHECK(sync.estimate().valid && sync.estimate().offsetNs == kOffset);
+}
+
+void testWindowWraps() {
+	ClockSync sync(2);
+	sync.add(exchange(0, 100, 100));    // delay 200
+	sync.add(exchange(1000, 200, 200)); // delay 400
+	CHECK(sync.estimate().delayNs == 200);
+	sync.add(exchange(2000, 300, 300)); // evicts the best
+	CHECK(sync.estimate().delayNs == 400);
+	sync.add(exchange(3000, 50, 50));   // evicts delay 400
+	CHECK(sync.estimate().delayNs == 100);
+
+	sync.reset();
+	CHECK(!sync.estimate().valid);
+
+	ClockSync single(0); // clamped to one
+	single.add(exchange(0, 100, 100));
+	single.add(exchange(0, 400, 400));
+	CHECK(single.estimate().delayNs == 800);
+}
+
+} // namespace
+
+int main() {
+	testParse();
+	testKnownOffset();
+	testAsymmetric();
+	testNegativeDelayRejected();
+	testWindowWraps();
+	return checkResult();
+}
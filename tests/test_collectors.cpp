@@ -0,0 +1,167 @@
+// Built once per collector selection (see CMakeLists.txt): each build checks
+// the frame BuildCollectors generates against the layout it should have.
+#include "sys_collectors.h"
+
+#include "check.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace sysmon;
+
+namespace {
+
+std::uint64_t getU(const unsigned char* p, int bytes) {
+	std::uint64_t v = 0;
+	for (int i = bytes - 1; i >= 0; --i) v = (v << 8) | p[i];
+	return v;
+}
+
+double getF64(const unsigned char* p) {
+	const std::uint64_t bits = getU(p, 8);
+	double v;
+	std::memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+// Runs check on C's record, for builds that include C.
+template <class C, class F>
+void withRecord(const unsigned char* frame, F check) {
+	if constexpr (kBuiltWith<C>) check(frame + BuildWireLayout::offsetOf<C>());
+}
+
+struct Expected {
+	std::uint32_t mask;
+	std::size_t size;
+	const char* schema;
+};
+
+// One entry per build configured in CMakeLists.txt.
+const Expected kExpected[] = {
+	{ 0x7F, 184, "SCHEMA v1 bytes=184 cpu@32+16 mem@48+24 mem_pressure@72+64 freq@136+32 cgroup@168+16 network@184+0 gpu@184+0" },
+	{ 0x03, 72, "SCHEMA v1 bytes=72 cpu@32+16 mem@48+24" },
+	{ 0x0A, 88, "SCHEMA v1 bytes=88 mem@32+24 freq@56+32" },
+	{ 0x40, 32, "SCHEMA v1 bytes=32 gpu@32+0" },
+};
+
+Sample knownSample(bool withCgroups) {
+	Sample s;
+	s.seq = 0x0102030405060708ULL;
+	s.monoNs = 123456789;
+	s.wallNs = 1700000000000000000ULL;
+	s.cpuPercent = { false, 0.0 }; // unavailable: NaN on the wire
+	s.corePercent = { 10.0, 20.0, 30.0 };
+	s.cpuPeriodMs = 500;
+	s.cpuFresh = true;
+	s.mem = { 16ULL << 30, 4ULL << 30, true };
+	s.memPeriodMs = 1000;
+	s.memFresh = true;
+	s.memPressure.commitBytes = 1000;
+	s.memPressure.standbyBytes = 2000;
+	s.memPressure.hardFaultsPerSec = { true, 2.5 };
+	s.memPressure.ok = true;
+	s.freq.cores = { { 2000, 3000, 3000 }, { 2400, 3600, 3600 } };
+	s.freq.perfLimitPercent = { true, 95.0 };
+	s.freq.throttled = true;
+	s.freq.ok = true;
+	s.freqFresh = true;
+	if (withCgroups) {
+		auto groups = std::make_shared<std::vector<CgroupUsage>>(2);
+		(*groups)[0].cpuPercent = 12.0;
+		(*groups)[1].cpuPercent = 48.0;
+		s.cgroups = groups;
+	}
+	s.cgroupFresh = true;
+	return s;
+}
+
+void testSchema() {
+	const Expected* e = nullptr;
+	for (const auto& x : kExpected) {
+		if (x.mask == BuildCollectors::kMask) e = &x;
+	}
+	CHECK(e != nullptr);
+	if (!e) return;
+	CHECK(BuildWireLayout::kSize == e->size);
+	CHECK(BuildWireLayout::describe() == e->schema);
+}
+
+void testHeader() {
+	std::vector<unsigned char> frame(BuildWireLayout::kSize + 1, 0xAA);
+	BuildWireLayout::encode(knownSample(true), frame.data());
+	const unsigned char* f = frame.data();
+	CHECK(f[0] == 'S' && f[1] == 'M' && f[2] == 1);
+	CHECK(f[3] == BuildCollectors::kMask);
+	CHECK(getU(f + 4, 2) == BuildWireLayout::kSize);
+	CHECK(getU(f + 6, 2) == 0);
+	CHECK(getU(f + 8, 8) == 0x0102030405060708ULL);
+	CHECK(f[8] == 0x08); // little-endian
+	CHECK(getU(f + 16, 8) == 123456789);
+	CHECK(getU(f + 24, 8) == 1700000000000000000ULL);
+	CHECK(frame.back() == 0xAA); // exactly kSize bytes written
+}
+
+void testRecords() {
+	std::vector<unsigned char> frame(BuildWireLayout::kSize);
+	BuildWireLayout::encode(knownSample(true), frame.data());
+	const unsigned char* f = frame.data();
+
+	withRecord<collect::Cpu>(f, [&](const unsigned char* p) {
+		CHECK(std::isnan(getF64(p)));
+		CHECK(getU(p + 8, 4) == 500);
+		CHECK(getU(p + 12, 2) == 3);
+		CHECK(p[14] == 1 && p[15] == 0);
+	});
+	withRecord<collect::Mem>(f, [&](const unsigned char* p) {
+		CHECK(getU(p, 8) == (16ULL << 30));
+		CHECK(getU(p + 8, 8) == (4ULL << 30));
+		CHECK(getU(p + 16, 4) == 1000);
+		CHECK(p[20] == 1 && p[21] == 1);
+	});
+	withRecord<collect::MemPressure>(f, [&](const unsigned char* p) {
+		CHECK(getU(p, 8) == 1000);
+		CHECK(getU(p + 24, 8) == 2000);
+		CHECK(std::isnan(getF64(p + 40)));
+		CHECK(getF64(p + 48) == 2.5);
+		CHECK(p[56] == 1 && p[57] == 0);
+	});
+	withRecord<collect::Freq>(f, [&](const unsigned char* p) {
+		CHECK(getF64(p) == 95.0);
+		CHECK(std::isnan(getF64(p + 8))); // no thermal zones
+		CHECK(getU(p + 16, 4) == 2200);
+		CHECK(getU(p + 20, 4) == 3600);
+		CHECK(p[24] == 1 && p[25] == 1 && p[26] == 1);
+	});
+	withRecord<collect::Cgroup>(f, [&](const unsigned char* p) {
+		CHECK(getF64(p) == 48.0);
+		CHECK(getU(p + 8, 4) == 2);
+
+		// No cgroup list at all: NaN and a zero count.
+		BuildWireLayout::encode(knownSample(false), frame.data());
+		CHECK(std::isnan(getF64(p)));
+		CHECK(getU(p + 8, 4) == 0);
+	});
+}
+
+// Offsets follow the order the set lists its tags, whatever the build.
+void testOrder() {
+	using Layout = WireLayout<CollectorSet<collect::Mem, collect::Cpu, collect::Gpu>>;
+	static_assert(Layout::offsetOf<collect::Mem>() == 32, "mem first");
+	static_assert(Layout::offsetOf<collect::Cpu>() == 56, "cpu after mem");
+	static_assert(Layout::offsetOf<collect::Gpu>() == 72, "gpu adds no bytes");
+	static_assert(Layout::kSize == 72 && CollectorSet<collect::Mem, collect::Cpu, collect::Gpu>::kMask == 67, "layout");
+	CHECK(Layout::describe() == "SCHEMA v1 bytes=72 mem@32+24 cpu@56+16 gpu@72+0");
+}
+
+} // namespace
+
+int main() {
+	testSchema();
+	testHeader();
+	testRecords();
+	testOrder();
+	return checkResult();
+}
@@ -0,0 +1,116 @@
+#include "sys_cpufreq.h"
+
+#include "check.h"
+
+#if defined(__linux__)
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#endif
+
+using namespace sysmon;
+
+namespace {
+
+#if defined(__linux__)
+
+void writeFile(const std::string& path, const std::string& text) {
+	if (FILE* f = std::fopen(path.c_str(), "w")) {
+		std::fputs(text.c_str(), f);
+		std::fclose(f);
+	}
+}
+
+void makeDirs(const std::string& path) {
+	for (std::size_t i = 1; i <= path.size(); ++i) {
+		if (i == path.size() || path[i] == '/') mkdir(path.substr(0, i).c_str(), 0755);
+	}
+}
+
+void makeCore(const std::string& cpuDir, int curKhz, int maxKhz) {
+	makeDirs(cpuDir + "/cpufreq");
+	writeFile(cpuDir + "/cpufreq/scaling_cur_freq", std::to_string(curKhz) + "\n");
+	writeFile(cpuDir + "/cpufreq/cpuinfo_max_freq", std::to_string(maxKhz) + "\n");
+	writeFile(cpuDir + "/cpufreq/scaling_max_freq", std::to_string(maxKhz) + "\n");
+}
+
+int removeEntry(const char* path, const struct stat*, int, FTW*) {
+	return remove(path);
+}
+
+// A fake sysfs tree in a temp directory: the monitor only needs the files.
+void testSysfs() {
+	char tmpl[] = "/tmp/sysmon_cpufreq_XXXXXX";
+	if (!mkdtemp(tmpl)) {
+		CHECK(!"mkdtemp failed");
+		return;
+	}
+	const std::string root = tmpl;
+	const std::string cpu = root + "/devices/system/cpu";
+	makeCore(cpu + "/cpu0", 1200000, 3600000);
+	makeCore(cpu + "/cpu10", 2000000, 3000000);
+	makeCore(cpu + "/cpu2", 800000, 3600000);
+	makeDirs(cpu + "/cpu2/thermal_throttle");
+	writeFile(cpu + "/cpu2/thermal_throttle/core_throttle_count", "7\n");
+	makeDirs(cpu + "/cpu3");   // no cpufreq driver: skipped
+	makeDirs(cpu + "/cpuidle"); // not a core
+	makeDirs(cpu + "/cpufreq");
+	const std::string thermal = root + "/class/thermal";
+	makeDirs(thermal + "/thermal_zone0");
+	writeFile(thermal + "/thermal_zone0/temp", "45500\n");
+	makeDirs(thermal + "/thermal_zone1");
+	writeFile(thermal + "/thermal_zone1/temp", "-2000\n");
+	makeDirs(thermal + "/cooling_device0");
+
+	{
+		CpuFreqMonitor mon;
+		CHECK(mon.initSysfs(root.c_str()));
+		CpuFreqInfo info;
+		CHECK(mon.sample(info));
+		CHECK(info.ok && !info.throttled && !info.perfLimitPercent.has);
+		// Numeric order, not directory order.
+		CHECK(info.cores.size() == 3);
+		CHECK(info.cores[0].currentMhz == 1200 && info.cores[0].maxMhz == 3600 && info.cores[0].limitMhz == 3600);
+		CHECK(info.cores[1].currentMhz == 800);
+		CHECK(info.cores[2].currentMhz == 2000 && info.cores[2].maxMhz == 3000);
+		CHECK(info.thermalZonesC.size() == 2);
+		CHECK(info.thermalZonesC[0] == 45.5 && info.thermalZonesC[1] == -2.0);
+
+		// The files are re-read in place on every sample.
+		writeFile(cpu + "/cpu0/cpufreq/scaling_cur_freq", "3400000\n");
+		writeFile(cpu + "/cpu10/cpufreq/scaling_max_freq", "2200000\n");
+		CHECK(mon.sample(info));
+		CHECK(info.cores[0].currentMhz == 3400);
+		CHECK(info.cores[2].limitMhz == 2200 && info.throttled);
+
+		// A rising throttle count flags the sample it rose in only.
+		writeFile(cpu + "/cpu10/cpufreq/scaling_max_freq", "3000000\n");
+		writeFile(cpu + "/cpu2/thermal_throttle/core_throttle_count", "9\n");
+		CHECK(mon.sample(info));
+		CHECK(info.throttled);
+		CHECK(mon.sample(info));
+		CHECK(!info.throttled);
+	}
+
+	nftw(root.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+	CpuFreqMonitor missing;
+	CHECK(!missing.initSysfs("/nonexistent/sys"));
+	CpuFreqInfo info;
+	CHECK(!missing.sample(info) && !info.ok && info.cores.empty());
+}
+
+#endif
+
+} // namespace
+
+int main() {
+#if defined(__linux__)
+	testSysfs();
+#endif
+	return checkResult();
+}
@@ -0,0 +1,133 @@
+#include "sys_mem.h"
+
+#include "check.h"
+
+#if defined(__linux__)
+#include <ftw.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#endif
+
+using namespace sysmon;
+
+namespace {
+
+#if defined(__linux__)
+
+void writeFile(const std::string& path, const std::string& text) {
+	if (FILE* f = std::fopen(path.c_str(), "w")) {
+		std::fputs(text.c_str(), f);
+		std::fclose(f);
+	}
+}
+
+std::string meminfo() {
+	return "MemTotal:       16000000 kB\n"
+	       "MemAvailable:    4000000 kB\n"
+	       "Cached:          3000000 kB\n"
+	       "SwapCached:         1000 kB\n"
+	       "Inactive(file):  1500000 kB\n"
+	       "Dirty:               200 kB\n"
+	       "Writeback:            56 kB\n"
+	       "CommitLimit:    12000000 kB\n"
+	       "Committed_AS:    9000000 kB\n";
+}
+
+// pgfault sits behind pgfault-like names, as in the real file.
+std::string vmstat(std::uint64_t faults, std::uint64_t majFaults) {
+	std::string text = "nr_free_pages 12345\n";
+	for (int i = 0; i < 200; ++i) text += "nr_filler_" + std::to_string(i) + " 0\n";
+	text += "pgfault_extra 999999\n";
+	text += "pgfault " + std::to_string(faults) + "\n";
+	text += "pgmajfault " + std::to_string(majFaults) + "\n";
+	return text;
+}
+
+int removeEntry(const char* path, const struct stat*, int, FTW*) {
+	return remove(path);
+}
+
+// Fixture files in a temp directory stand in for /proc.
+void testProc() {
+	char tmpl[] = "/tmp/sysmon_mem_XXXXXX";
+	if (!mkdtemp(tmpl)) {
+		CHECK(!"mkdtemp failed");
+		return;
+	}
+	const std::string root = tmpl;
+	writeFile(root + "/meminfo", meminfo());
+	writeFile(root + "/vmstat", vmstat(1000, 10));
+
+	{
+		MemPressureMonitor mon;
+		CHECK(mon.initProc(root.c_str()));
+		MemPressure mp;
+		CHECK(mon.sample(mp));
+		CHECK(mp.ok && mp.haveLists);
+		CHECK(mp.commitBytes == 9000000ULL * 1024 && mp.commitLimitBytes == 12000000ULL * 1024);
+		CHECK(mp.systemCacheBytes == 3000000ULL * 1024);
+		CHECK(mp.standbyBytes == 1500000ULL * 1024 && mp.modifiedBytes == 256ULL * 1024);
+		// Rates need a previous sample; no PSI file, no stall figures.
+		CHECK(!mp.pageFaultsPerSec.has && !mp.hardFaultsPerSec.has);
+		CHECK(!mp.stallSomeAvg10.has && !mp.stallFullAvg60.has);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		writeFile(root + "/vmstat", vmstat(2000, 15));
+		CHECK(mon.sample(mp));
+		CHECK(mp.pageFaultsPerSec.has && mp.hardFaultsPerSec.has);
+		// 1000 and 5 faults over at least 20 ms.
+		CHECK(mp.pageFaultsPerSec.value > 0.0 && mp.pageFaultsPerSec.value <= 50000.0);
+		CHECK(mp.hardFaultsPerSec.value > 0.0 && mp.hardFaultsPerSec.value <= 250.0);
+
+		// A counter going backwards (wrap, fixture reset) yields no rate.
+		writeFile(root + "/vmstat", vmstat(5, 1));
+		CHECK(mon.sample(mp));
+		CHECK(!mp.pageFaultsPerSec.has);
+	}
+
+	// PSI is opened in init(), like the rest.
+	mkdir((root + "/pressure").c_str(), 0755);
+	writeFile(root + "/pressure/memory",
+		"some avg10=1.50 avg60=0.75 avg300=0.10 total=123456\n"
+		"full avg10=0.25 avg60=0.00 avg300=0.00 total=789\n");
+	{
+		MemPressureMonitor mon;
+		CHECK(mon.initProc(root.c_str()));
+		MemPressure mp;
+		CHECK(mon.sample(mp));
+		CHECK(mp.stallSomeAvg10.has && mp.stallSomeAvg10.value == 1.5);
+		CHECK(mp.stallSomeAvg60.has && mp.stallSomeAvg60.value == 0.75);
+		CHECK(mp.stallFullAvg10.has && mp.stallFullAvg10.value == 0.25);
+		CHECK(mp.stallFullAvg60.has && mp.stallFullAvg60.value == 0.0);
+	}
+
+	nftw(root.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+	MemPressureMonitor missing;
+	CHECK(!missing.initProc("/nonexistent/proc"));
+	MemPressure mp;
+	CHECK(!missing.sample(mp) && !mp.ok);
+}
+
+// The real /proc: whatever the kernel, MemTotal and MemAvailable are there.
+void testMemInfo() {
+	const MemInfo mi = getMemInfo();
+	CHECK(mi.ok && mi.totalPhysBytes > 0 && mi.availPhysBytes <= mi.totalPhysBytes);
+}
+
+#endif
+
+} // namespace
+
+int main() {
+#if defined(__linux__)
+	testProc();
+	testMemInfo();
+#endif
+	return checkResult();
+}
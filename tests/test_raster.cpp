@@ -0,0 +1,120 @@
+#include "ui_raster.h"
+
+#include "check.h"
+
+#include <vector>
+
+using namespace sysmon;
+
+namespace {
+
+struct Canvas {
+	std::vector<std::uint32_t> pixels;
+	Surface surface;
+
+	Canvas(int w, int h, int stride = 0) : pixels(static_cast<std::size_t>((stride ? stride : w) * h), 0xDEADBEEF) {
+		surface = { pixels.data(), w, h, stride ? stride : w };
+	}
+	std::uint32_t at(int x, int y) const { return pixels[static_cast<std::size_t>(y * surface.stride + x)]; }
+	int count(std::uint32_t color) const {
+		int n = 0;
+		for (int y = 0; y < surface.height; ++y)
+			for (int x = 0; x < surface.width; ++x) n += at(x, y) == color;
+		return n;
+	}
+};
+
+constexpr std::uint32_t kInk = packRgb(255, 0, 0);
+
+void testGradient() {
+	Canvas c(4, 5, 6);
+	fillVerticalGradient(c.surface, packRgb(0, 0, 0), packRgb(250, 100, 50));
+	// Row y gets lerp(top, bottom, y, height): row 0 is `top`, rows are uniform.
+	CHECK(c.at(0, 0) == packRgb(0, 0, 0));
+	CHECK(c.at(0, 4) == packRgb(200, 80, 40));
+	CHECK(c.at(0, 2) == packRgb(100, 40, 20));
+	for (int y = 0; y < 5; ++y) CHECK(c.at(3, y) == c.at(0, y));
+	// Padding past width stays untouched.
+	CHECK(c.pixels[4] == 0xDEADBEEF && c.pixels[5] == 0xDEADBEEF);
+
+	Surface empty;
+	fillVerticalGradient(empty, 0, 0); // no pixels: no-op
+}
+
+void testClipRect() {
+	Canvas c(10, 8);
+	const RasterRect r = clipRect(c.surface, { -5, -3, 20, 4 });
+	CHECK(r.left == 0 && r.top == 0 && r.right == 10 && r.bottom == 4);
+	const RasterRect out = clipRect(c.surface, { 12, 9, 15, 11 });
+	CHECK(out.right - out.left == 0 && out.bottom - out.top == 0);
+}
+
+void testCopyRect() {
+	Canvas src(8, 6);
+	Canvas dst(8, 6);
+	fillRect(src.surface, { 0, 0, 8, 6 }, kInk);
+
+	// Straddles the top-left corner; only the on-surface part is copied.
+	copyRect(src.surface, dst.surface, { -2, -2, 3, 2 });
+	CHECK(dst.count(kInk) == 3 * 2);
+	CHECK(dst.at(2, 1) == kInk && dst.at(3, 1) == 0xDEADBEEF && dst.at(2, 2) == 0xDEADBEEF);
+
+	// Entirely off-surface: nothing changes.
+	copyRect(src.surface, dst.surface, { 9, 7, 12, 10 });
+	CHECK(dst.count(kInk) == 6);
+
+	// Size mismatch is rejected.
+	Canvas other(7, 6);
+	copyRect(src.surface, other.surface, { 0, 0, 7, 6 });
+	CHECK(other.count(kInk) == 0);
+}
+
+void testLineEndpoints() {
+	const int cases[][4] = { { 0, 0, 9, 3 }, { 9, 3, 0, 0 }, { 2, 7, 2, 0 }, { 0, 5, 7, 5 }, { 1, 1, 6, 6 }, { 8, 0, 0, 7 }, { 4, 4, 4, 4 } };
+	for (const auto& l : cases) {
+		Canvas c(10, 8);
+		drawLine(c.surface, l[0], l[1], l[2], l[3], kInk);
+		CHECK(c.at(l[0], l[1]) == kInk);
+		CHECK(c.at(l[2], l[3]) == kInk);
+		// One pixel per step along the major axis, both ends included.
+		const int dx = l[2] > l[0] ? l[2] - l[0] : l[0] - l[2];
+		const int dy = l[3] > l[1] ? l[3] - l[1] : l[1] - l[3];
+		CHECK(c.count(kInk) == (dx > dy ? dx : dy) + 1);
+	}
+}
+
+void testLineClipping() {
+	Canvas c(10, 8);
+	// Crosses the whole surface diagonally from far outside.
+	drawLine(c.surface, -20, -20, 30, 30, kInk);
+	CHECK(c.count(kInk) == 8); // (0,0)..(7,7)
+	CHECK(c.at(0, 0) == kInk && c.at(7, 7) == kInk);
+
+	Canvas d(10, 8);
+	drawLine(d.surface, -5, 20, 40, 20, kInk); // never on the surface
+	CHECK(d.count(kInk) == 0);
+}
+
+void testSparkline() {
+	Canvas c(20, 10);
+	const double values[] = { 0.0, 100.0, 50.0 };
+	drawSparkline(c.surface, { 2, 1, 12, 9 }, values, 3, 0.0, 100.0, kInk);
+	CHECK(c.at(2, 8) == kInk);  // first value on the bottom edge, left
+	CHECK(c.at(7, 1) == kInk);  // max on the top edge, middle
+	CHECK(c.at(11, 4) == kInk); // 50%: 8 - round(0.5 * 7) at the right edge
+	for (int y = 0; y < 10; ++y) {
+		CHECK(c.at(0, y) != kInk && c.at(1, y) != kInk && c.at(12, y) != kInk);
+	}
+}
+
+} // namespace
+
+int main() {
+	testGradient();
+	testClipRect();
+	testCopyRect();
+	testLineEndpoints();
+	testLineClipping();
+	testSparkline();
+	return checkResult();
+}
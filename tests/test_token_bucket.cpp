@@ -0,0 +1,56 @@
+#include "token_bucket.h"
+
+#include "check.h"
+
+using namespace sysmon;
+
+namespace {
+
+void testBurstThenRate() {
+	TokenBucket b{ 3.0, 1000 }; // starts full, as the server seeds new sources
+	CHECK(b.take(2.0, 3.0, 1000));
+	CHECK(b.take(2.0, 3.0, 1000));
+	CHECK(b.take(2.0, 3.0, 1000));
+	CHECK(!b.take(2.0, 3.0, 1000));
+	// 2 per second: one token every 500 ms.
+	CHECK(!b.take(2.0, 3.0, 1400));
+	CHECK(b.take(2.0, 3.0, 1500));
+	CHECK(!b.take(2.0, 3.0, 1500));
+	CHECK(b.take(2.0, 3.0, 2000));
+}
+
+void testBurstCap() {
+	TokenBucket b{ 0.0, 0 };
+	b.refill(5.0, 20.0, 60000); // a minute idle still only banks the burst
+	CHECK(b.tokens == 20.0);
+	int taken = 0;
+	while (b.take(5.0, 20.0, 60000)) ++taken;
+	CHECK(taken == 20);
+}
+
+void testFractionalRate() {
+	TokenBucket b{ 0.0, 0 };
+	CHECK(!b.take(1.0 / 3.0, 5.0, 2999));
+	CHECK(b.take(1.0 / 3.0, 5.0, 3001));
+}
+
+// A timestamp older than the last one (never expected from a monotonic
+// clock) neither mints nor burns tokens.
+void testBackwardsTime() {
+	TokenBucket b{ 1.0, 5000 };
+	b.refill(1.0, 5.0, 1000);
+	CHECK(b.tokens == 1.0 && b.lastMs == 5000);
+	CHECK(b.take(1.0, 5.0, 1000));
+	CHECK(!b.take(1.0, 5.0, 5500));
+	CHECK(b.take(1.0, 5.0, 6000));
+}
+
+} // namespace
+
+int main() {
+	testBurstThenRate();
+	testBurstCap();
+	testFractionalRate();
+	testBackwardsTime();
+	return checkResult();
+}
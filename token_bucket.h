@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace sysmon {
+
+// Classic token bucket: `perSec` tokens accrue per second up to `burst`, and
+// each admitted action spends one. Times are caller-supplied milliseconds
+// (GetTickCount64() in the server), so this stays free of OS headers. The
+// rate and burst are passed on every call rather than stored, so one limits
+// struct can drive any number of buckets.
+struct TokenBucket {
+	double tokens{};
+	std::uint64_t lastMs{};
+
+	void refill(double perSec, double burst, std::uint64_t nowMs) {
+		if (nowMs > lastMs) tokens += static_cast<double>(nowMs - lastMs) * perSec / 1000.0;
+		tokens = std::min(burst, tokens);
+		lastMs = std::max(lastMs, nowMs);
+	}
+
+	bool take(double perSec, double burst, std::uint64_t nowMs) {
+		refill(perSec, burst, nowMs);
+		if (tokens < 1.0) return false;
+		tokens -= 1.0;
+		return true;
+	}
+};
+
+} // namespace sysmon
@@ -2,34 +2,42 @@
 
 #include "network_server.h"
 
+#include "sys_alert.h"
+#include "sys_alloc_guard.h"
+#include "sys_clock.h"
+#include "sys_collectors.h"
 #include "sys_cpu.h"
-#include "sys_gpu.h"
 #include "sys_mem.h"
-#include "sys_monitor.h"
 #include "sys_rss.h"
+#include "sys_sampler.h"
+#include "sys_startup.h"
+#include "sys_worker_pool.h"
+#include "ui_raster.h"
 
 #include <windows.h>
 #include <shellapi.h>
 #include <commctrl.h>
-#include <iphlpapi.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
+#include <algorithm>
 #include <atomic>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
 
-#pragma comment(lib, "iphlpapi.lib")
-
 namespace sysmon {
 
 static constexpr wchar_t kWndClassName[] = L"SysMonitorTrayWnd";
 static constexpr UINT WM_TRAYICON = WM_APP + 1;
-static constexpr UINT_PTR TIMER_ID_SEND = 1;
+// Posted by the sampler thread when a snapshot worth showing was published
+// (a stream tick with a new sparkline point, or refreshed device info).
+static constexpr UINT WM_SAMPLE = WM_APP + 2;
 
 static constexpr int IDC_PORT = 1001;
 static constexpr int IDC_BTN_TOGGLE = 1002;
@@ -42,134 +50,43 @@ static constexpr std::uint16_t kMaxPort = 50000;
 
 // Adjust window height to accommodate extra IP lines.
 static constexpr int kWndWidth = 420;
-static constexpr int kWndHeight = 320; // Increased from 290 to fit 3 IP lines comfortably
-
-static std::string narrowUtf8(const std::wstring& ws) {
-	if (ws.empty()) return {};
-	int len = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, nullptr, 0, nullptr, nullptr);
-	if (len <= 0) return {};
-	std::string s(static_cast<size_t>(len - 1), '\0');
-	WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, &s[0], len, nullptr, nullptr);
-	return s;
-}
-
-static std::wstring widen(const std::string& s) {
-	if (s.empty()) return {};
-	int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
-	if (len <= 0) return {};
-	std::wstring ws(static_cast<size_t>(len - 1), L'\0');
-	MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &ws[0], len);
-	return ws;
-}
-
-static std::wstring readCpuBrandString() {
-	HKEY hKey{};
-	if (RegOpenKeyExW(HKEY_LOCAL_MACHINE,
-		L"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0",
-		0,
-		KEY_QUERY_VALUE | KEY_WOW64_64KEY,
-		&hKey) != ERROR_SUCCESS) {
-		return {};
-	}
-
-	DWORD type = 0;
-	DWORD size = 0;
-	if (RegQueryValueExW(hKey, L"ProcessorNameString", nullptr, &type, nullptr, &size) != ERROR_SUCCESS || type != REG_SZ || size == 0) {
-		RegCloseKey(hKey);
-		return {};
-	}
-
-	std::wstring value(size / sizeof(wchar_t), L'\0');
-	if (RegQueryValueExW(hKey, L"ProcessorNameString", nullptr, &type, reinterpret_cast<LPBYTE>(&value[0]), &size) != ERROR_SUCCESS) {
-		RegCloseKey(hKey);
-		return {};
-	}
-	RegCloseKey(hKey);
-
-	while (!value.empty() && value.back() == L'\0') value.pop_back();
-	return value;
-}
-
-struct NetId {
-	std::string mac;
-	std::vector<std::string> ips;
+static constexpr int kWndHeight = 380; // Increased from 320 to fit the CPU/RAM sparklines below the info box
+
+static constexpr std::size_t kSparkPoints = 60;
+static constexpr RasterRect kCpuSparkRect{ 10, 268, 195, 328 };
+static constexpr RasterRect kMemSparkRect{ 205, 268, 390, 328 };
+static constexpr std::uint32_t kGradientTop = packRgb(255, 255, 255);
+static constexpr std::uint32_t kGradientBottom = packRgb(200, 235, 200);
+
+struct SparkHistory {
+	double cpu[kSparkPoints]{};
+	double memUsed[kSparkPoints]{};
+	std::size_t count{};
+	std::size_t head{}; // next slot to write
 };
 
-static bool getPrimaryNetId(NetId& out) {
-	out = {};
-
-	ULONG size = 0;
-	if (GetAdaptersInfo(nullptr, &size) != ERROR_BUFFER_OVERFLOW || size == 0) {
-		return false;
-	}
-
-	std::vector<unsigned char> buf(size);
-	auto* info = reinterpret_cast<PIP_ADAPTER_INFO>(buf.data());
-	if (GetAdaptersInfo(info, &size) != NO_ERROR) {
-		return false;
-	}
-
-	for (auto* a = info; a; a = a->Next) {
-		if (a->Type == MIB_IF_TYPE_LOOPBACK) continue;
-		if (a->AddressLength < 6) continue;
-
-		std::ostringstream mac;
-		mac << std::hex << std::setfill('0');
-		for (UINT i = 0; i < a->AddressLength; ++i) {
-			if (i) mac << ":";
-			mac << std::setw(2) << static_cast<int>(a->Address[i]);
-		}
-		out.mac = mac.str();
-
-		for (auto* ip = &a->IpAddressList; ip; ip = ip->Next) {
-			if (ip->IpAddress.String[0] == '\0') continue;
-			std::string s = ip->IpAddress.String;
-			if (s == "0.0.0.0") continue;
-			out.ips.push_back(std::move(s));
-		}
-
-		if (!out.mac.empty() || !out.ips.empty()) return true;
-	}
-
-	return false;
-}
-
-static std::wstring formatDeviceInfo() {
-	auto mem = getMemInfo();
-	auto gpu = getGpuVideoMemoryInfo();
-	auto cpuName = readCpuBrandString();
-
-	NetId net;
-	bool hasNet = getPrimaryNetId(net);
-
-	auto gb = [](std::uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0 * 1024.0); };
-
-	std::wostringstream oss;
-	oss << L"CPU: " << (cpuName.empty() ? L"n/a" : cpuName) << L"\r\n";
-	oss << L"GPU: " << (gpu.adapterName.empty() ? L"n/a" : gpu.adapterName) << L"\r\n";
-
-	oss << L"Total RAM: ";
-	if (mem.ok) {
-		oss << std::fixed << std::setprecision(1) << gb(mem.totalPhysBytes) << L" GB";
-	} else {
-		oss << L"n/a";
-	}
-	oss << L"\r\n";
-
-	oss << L"MAC: " << (hasNet && !net.mac.empty() ? widen(net.mac) : L"n/a") << L"\r\n";
-
-	auto ipOr = [&](size_t idx) -> std::wstring {
-		if (!hasNet || idx >= net.ips.size()) return L""; // Empty string if not present
-		return widen(net.ips[idx]);
-	};
-
-	// Three distinct lines for IPs
-	oss << L"IP1: " << (ipOr(0).empty() ? L"n/a" : ipOr(0)) << L"\r\n";
-	oss << L"IP2: " << (ipOr(1).empty() ? L"n/a" : ipOr(1)) << L"\r\n";
-	oss << L"IP3: " << (ipOr(2).empty() ? L"n/a" : ipOr(2)) << L"\r\n";
+// Client-area raster cache. `background` holds the gradient, rendered once
+// per size; `frame` (a DIB section selected into memDc) is the background
+// plus sparklines and is what WM_ERASEBKGND blits.
+struct UiCanvas {
+	int width{};
+	int height{};
+	std::vector<std::uint32_t> background;
+	HDC memDc{};
+	HBITMAP dib{};
+	HGDIOBJ oldBitmap{};
+	std::uint32_t* frame{};
+};
 
-	return oss.str();
-}
+// Redraw cost counters, read by the "STATS UI" command from the server thread.
+struct PaintStats {
+	std::atomic<std::uint64_t> erases{};
+	std::atomic<std::uint64_t> eraseNs{};
+	std::atomic<std::uint64_t> rasters{};
+	std::atomic<std::uint64_t> rasterNs{};
+	std::atomic<std::uint64_t> backgrounds{};
+	std::atomic<std::uint64_t> backgroundNs{};
+};
 
 struct AppState {
 	HINSTANCE hInst{};
@@ -180,16 +97,46 @@ struct AppState {
 	HWND hIps{};
 	NOTIFYICONDATAW nid{};
 
-	CpuMonitor cpuMon;
 	std::atomic<bool> running{};
 	std::uint16_t port{};
+	ServerLimits serverLimits;
+	ThreadPolicy serverPolicy;
+	// Guards `server` against the sampler thread pushing alerts while it is torn down.
+	std::mutex serverMutex;
 	NetworkServer* server{};
 	HANDLE serverThread{};
+
+	Sampler* sampler{};
+	// Runs the slow identity probes during startup; gone once they finish.
+	WorkerPool* probes{};
+	StartupTimeline startup;
+	AlertEngine alerts;
+	std::vector<AlertEvent> alertScratch;
+	// ALERT RAISE lines for the alerts active now, replayed to new subscribers.
+	// Rewritten by the sampler thread on every transition.
+	std::mutex raisedMutex;
+	std::string raisedLines;
+
+	std::mutex historyMutex;
+	SparkHistory history;
+	// Device report currently shown in hIps; kept alive while displayed.
+	std::shared_ptr<const DeviceReport> shownDevice;
+	UiCanvas canvas;
+	PaintStats paintStats;
 };
 
+// Reads only the latest published snapshot; never collects on the UI thread.
+static void showDeviceInfo(AppState& st) {
+	auto snap = st.sampler ? st.sampler->latest() : nullptr;
+	auto device = snap ? snap->device : nullptr;
+	if (device && device == st.shownDevice) return;
+	st.shownDevice = device;
+	SetWindowTextW(st.hIps, device ? device->text.c_str() : L"Collecting...");
+	RedrawWindow(st.hIps, nullptr, nullptr, RDW_INVALIDATE | RDW_ERASE);
+}
+
 static void updateUi(AppState& st) {
-	SetWindowTextW(st.hIps, formatDeviceInfo().c_str());
-	RedrawWindow(st.hIps, nullptr, nullptr, RDW_INVALIDATE | RDW_ERASE | RDW_UPDATENOW);
+	showDeviceInfo(st);
 
 	if (st.running.load()) {
 		SetWindowTextW(st.hStatus, (L"Listening on port " + std::to_wstring(st.port)).c_str());
@@ -203,7 +150,7 @@ static void updateUi(AppState& st) {
 	GetWindowRect(st.hStatus, &rc);
 	MapWindowPoints(nullptr, st.hwnd, reinterpret_cast<POINT*>(&rc), 2);
 	InflateRect(&rc, 2, 2);
-	RedrawWindow(st.hwnd, &rc, nullptr, RDW_INVALIDATE | RDW_ERASE | RDW_UPDATENOW);
+	RedrawWindow(st.hwnd, &rc, nullptr, RDW_INVALIDATE | RDW_ERASE);
 }
 
 static bool parsePortFromEdit(HWND hEdit, std::uint16_t& outPort) {
@@ -230,25 +177,95 @@ static void stopServer(AppState& st) {
 		st.serverThread = nullptr;
 	}
 
+	std::lock_guard<std::mutex> lock(st.serverMutex);
 	if (st.server) {
 		delete st.server;
 		st.server = nullptr;
 	}
 }
 
+static std::string formatPaintStats(const PaintStats& ps) {
+	auto avgUs = [](const std::atomic<std::uint64_t>& ns, const std::atomic<std::uint64_t>& n) {
+		const std::uint64_t count = n.load(std::memory_order_relaxed);
+		return count ? static_cast<double>(ns.load(std::memory_order_relaxed)) / 1000.0 / static_cast<double>(count) : 0.0;
+	};
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(1);
+	oss << "UI erase=" << ps.erases.load() << " erase_us=" << avgUs(ps.eraseNs, ps.erases);
+	oss << " raster=" << ps.rasters.load() << " raster_us=" << avgUs(ps.rasterNs, ps.rasters);
+	oss << " background=" << ps.backgrounds.load() << " background_us=" << avgUs(ps.backgroundNs, ps.backgrounds);
+	oss << "\r\n";
+	return oss.str();
+}
+
+// Same count the ndjson stream carries.
+static constexpr std::size_t kDefaultTopCgroups = 8;
+
+// "TOP CGROUPS [cpu|mem] [N]" against the latest snapshot; by CPU unless told otherwise.
+static bool formatTopCgroups(const AppState& st, const std::string& args, std::string& reply) {
+	std::istringstream iss(args);
+	std::string key = "cpu";
+	std::size_t n = kDefaultTopCgroups;
+	iss >> key;
+	if (!(iss >> n)) n = kDefaultTopCgroups;
+	CgroupSort by;
+	if (key == "cpu") by = CgroupSort::Cpu;
+	else if (key == "mem") by = CgroupSort::Memory;
+	else return false;
+
+	auto snap = st.sampler ? st.sampler->latest() : nullptr;
+	if (!snap || !snap->sample.cgroups) {
+		reply = "CGROUP unavailable\r\n";
+		return true;
+	}
+	reply = formatCgroupTop(*snap->sample.cgroups, by, n);
+	return true;
+}
+
 static void startServer(AppState& st, std::uint16_t port) {
 	stopServer(st);
 	if (port < kMinPort || port > kMaxPort) port = kDefaultPort;
 	st.port = port;
 	st.running = true;
 
-	st.server = new NetworkServer(port, [&st]() {
-		// Reuse the same info shown in UI, but send it as UTF-8 over TCP.
-		return narrowUtf8(formatDeviceInfo());
-	});
+	{
+		std::lock_guard<std::mutex> lock(st.serverMutex);
+		st.server = new NetworkServer(port, [&st](Encoding enc, std::string& out) {
+			// Text reuses the same info shown in UI, already rendered as UTF-8 by the sampler.
+			auto snap = st.sampler ? st.sampler->latest() : nullptr;
+			if (snap) encodeSnapshot(*snap, enc, out);
+		}, st.serverLimits);
+		st.server->setCommandHandler([&st](const std::string& cmd, std::string& reply) {
+			if (cmd == "STATS JITTER" && st.sampler) {
+				reply = st.sampler->jitter().format();
+				return true;
+			}
+			if (cmd == "STATS UI") {
+				reply = formatPaintStats(st.paintStats);
+				return true;
+			}
+			if (cmd == "STATS ALLOC") {
+				reply = formatAllocStats();
+				return true;
+			}
+			if (cmd == "STATS STARTUP") {
+				reply = st.startup.format();
+				return true;
+			}
+			if (cmd == "TOP CGROUPS" || cmd.compare(0, 12, "TOP CGROUPS ") == 0) {
+				return formatTopCgroups(st, cmd.substr(std::min<std::size_t>(cmd.size(), 12)), reply);
+			}
+			return false;
+		});
+		st.server->setAlertReplay([&st](std::string& lines) {
+			std::lock_guard<std::mutex> lock(st.raisedMutex);
+			lines += st.raisedLines;
+		});
+	}
 
 	st.serverThread = CreateThread(nullptr, 0, [](LPVOID p) -> DWORD {
 		auto* stp = reinterpret_cast<AppState*>(p);
+		applyThreadPolicy(stp->serverPolicy);
 		NetworkServer* srv = stp->server;
 		if (srv) srv->run();
 		return 0;
@@ -256,11 +273,97 @@ static void startServer(AppState& st, std::uint16_t port) {
 
 	if (!st.serverThread) {
 		st.running = false;
+		std::lock_guard<std::mutex> lock(st.serverMutex);
 		delete st.server;
 		st.server = nullptr;
 	}
 }
 
+// Runs on the sampler thread for every sample, so alert latency is one sampling period.
+static void onSample(AppState& st, const Sample& s) {
+	if (s.cpuFresh && !st.startup.reached(StartupPhase::FirstSample)) st.startup.mark(StartupPhase::FirstSample);
+	if (s.streamTick) {
+		{
+			std::lock_guard<std::mutex> lock(st.historyMutex);
+			auto& h = st.history;
+			h.cpu[h.head] = s.cpuPercent.has ? s.cpuPercent.value : 0.0;
+			h.memUsed[h.head] = (s.mem.ok && s.mem.totalPhysBytes)
+				? 100.0 - (static_cast<double>(s.mem.availPhysBytes) * 100.0) / static_cast<double>(s.mem.totalPhysBytes)
+				: 0.0;
+			h.head = (h.head + 1) % kSparkPoints;
+			if (h.count < kSparkPoints) ++h.count;
+		}
+	}
+	if (s.streamTick || s.deviceFresh) PostMessageW(st.hwnd, WM_SAMPLE, 0, 0);
+
+	st.alertScratch.clear();
+	st.alerts.evaluate(s, st.alertScratch);
+	if (st.alertScratch.empty() && !s.streamTick) return;
+
+	if (!st.alertScratch.empty()) {
+		AllocGuardExempt exempt;
+		std::vector<AlertEvent> active;
+		st.alerts.active(active);
+		std::string lines;
+		for (const auto& ev : active) lines += formatAlertLine(ev);
+		std::lock_guard<std::mutex> lock(st.raisedMutex);
+		st.raisedLines.swap(lines);
+	}
+
+	std::lock_guard<std::mutex> lock(st.serverMutex);
+	if (!st.server) return;
+	if (!st.alertScratch.empty()) {
+		// Alert transitions are rare events, not per-tick work.
+		AllocGuardExempt exempt;
+		for (const auto& ev : st.alertScratch) {
+			st.server->pushEvent(formatAlertLine(ev));
+		}
+	}
+	if (s.streamTick) st.server->notifyTick();
+}
+
+// Created before the window so the startup probes have somewhere to deliver
+// their results; started once the window exists.
+static void createSampler(AppState& st) {
+	st.sampler = new Sampler([&st](const Sample& s) { onSample(st, s); });
+}
+
+static void startSampler(AppState& st, const SamplerConfig& cfg) {
+	// A sampler that failed to start is kept: probes may still be calling into it.
+	if (st.sampler && !st.sampler->start(cfg)) std::cerr << "Sampler failed to start.\n";
+}
+
+// Registry and DXGI lookups run in parallel with window creation; each one
+// fills its line in as soon as it completes.
+static void startProbes(AppState& st) {
+	st.probes = new WorkerPool(kBuiltWith<collect::Gpu> ? 2 : 1);
+	st.probes->submit([&st] {
+		st.sampler->setDeviceName(DeviceName::Cpu, probeCpuName());
+		st.startup.mark(StartupPhase::CpuName);
+	});
+	if constexpr (kBuiltWith<collect::Gpu>) {
+		st.probes->submit([&st] {
+			st.sampler->setDeviceName(DeviceName::Gpu, probeGpuName());
+			st.startup.mark(StartupPhase::GpuName);
+		});
+	}
+}
+
+// Must run before stopSampler(): a running probe still calls into the sampler.
+static void stopProbes(AppState& st) {
+	if (!st.probes) return;
+	st.probes->shutdown();
+	delete st.probes;
+	st.probes = nullptr;
+}
+
+static void stopSampler(AppState& st) {
+	if (!st.sampler) return;
+	st.sampler->stop();
+	delete st.sampler;
+	st.sampler = nullptr;
+}
+
 static void addTrayIcon(AppState& st) {
 	st.nid.cbSize = sizeof(st.nid);
 	st.nid.hWnd = st.hwnd;
@@ -313,35 +416,104 @@ static void showTrayMenu(AppState& st) {
 	}
 }
 
-static COLORREF lerpColor(COLORREF a, COLORREF b, int t, int tmax) {
-	auto la = [&](int c) { return GetRValue(c); };
-	auto ga = [&](int c) { return GetGValue(c); };
-	auto ba = [&](int c) { return GetBValue(c); };
-
-	int ar = la(a), ag = ga(a), ab = ba(a);
-	int br = la(b), bg = ga(b), bb = ba(b);
-	int r = ar + ((br - ar) * t) / tmax;
-	int g = ag + ((bg - ag) * t) / tmax;
-	int bl = ab + ((bb - ab) * t) / tmax;
-	return RGB(r, g, bl);
+static Surface backgroundSurface(UiCanvas& c) {
+	return { c.background.data(), c.width, c.height, c.width };
+}
+
+static Surface frameSurface(UiCanvas& c) {
+	return { c.frame, c.width, c.height, c.width };
+}
+
+static RECT toRect(const RasterRect& r) {
+	return { r.left, r.top, r.right, r.bottom };
+}
+
+static void releaseCanvas(UiCanvas& c) {
+	if (c.memDc) {
+		if (c.oldBitmap) SelectObject(c.memDc, c.oldBitmap);
+		DeleteDC(c.memDc);
+	}
+	if (c.dib) DeleteObject(c.dib);
+	c = UiCanvas{};
+}
+
+// Restores the sparkline areas from the cached background and redraws them.
+static void renderSparklines(AppState& st) {
+	UiCanvas& c = st.canvas;
+	if (!c.frame) return;
+	const std::uint64_t t0 = monotonicNs();
+
+	double cpu[kSparkPoints];
+	double mem[kSparkPoints];
+	std::size_t n = 0;
+	{
+		std::lock_guard<std::mutex> lock(st.historyMutex);
+		const auto& h = st.history;
+		n = h.count;
+		const std::size_t first = (h.head + kSparkPoints - h.count) % kSparkPoints;
+		for (std::size_t i = 0; i < n; ++i) {
+			cpu[i] = h.cpu[(first + i) % kSparkPoints];
+			mem[i] = h.memUsed[(first + i) % kSparkPoints];
+		}
+	}
+
+	// GDI may still be writing into the DIB (labels from the last pass).
+	GdiFlush();
+	Surface bg = backgroundSurface(c);
+	Surface frame = frameSurface(c);
+	copyRect(bg, frame, kCpuSparkRect);
+	copyRect(bg, frame, kMemSparkRect);
+	drawSparkline(frame, kCpuSparkRect, cpu, n, 0.0, 100.0, packRgb(40, 90, 200));
+	drawSparkline(frame, kMemSparkRect, mem, n, 0.0, 100.0, packRgb(30, 140, 60));
+
+	SetBkMode(c.memDc, TRANSPARENT);
+	SetTextColor(c.memDc, RGB(80, 80, 80));
+	TextOutW(c.memDc, kCpuSparkRect.left + 2, kCpuSparkRect.top, L"CPU", 3);
+	TextOutW(c.memDc, kMemSparkRect.left + 2, kMemSparkRect.top, L"RAM", 3);
+
+	st.paintStats.rasters.fetch_add(1, std::memory_order_relaxed);
+	st.paintStats.rasterNs.fetch_add(monotonicNs() - t0, std::memory_order_relaxed);
 }
 
-static void paintGradientBackground(HDC hdc, const RECT& rc) {
-	const COLORREF top = RGB(255, 255, 255);
-	const COLORREF bottom = RGB(200, 235, 200);
-
-	int h = rc.bottom - rc.top;
-	if (h <= 0) return;
-
-	for (int y = 0; y < h; ++y) {
-		COLORREF c = lerpColor(top, bottom, y, h);
-		HPEN pen = CreatePen(PS_SOLID, 1, c);
-		HGDIOBJ oldPen = SelectObject(hdc, pen);
-		MoveToEx(hdc, rc.left, rc.top + y, nullptr);
-		LineTo(hdc, rc.right, rc.top + y);
-		SelectObject(hdc, oldPen);
-		DeleteObject(pen);
+// (Re)builds the canvas when the client size changes; the gradient itself
+// is only ever rendered here.
+static bool ensureCanvas(AppState& st, int w, int h) {
+	UiCanvas& c = st.canvas;
+	if (c.frame && c.width == w && c.height == h) return true;
+	releaseCanvas(c);
+	if (w <= 0 || h <= 0) return false;
+
+	BITMAPINFO bmi{};
+	bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+	bmi.bmiHeader.biWidth = w;
+	bmi.bmiHeader.biHeight = -h; // top-down
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+
+	void* bits = nullptr;
+	c.dib = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+	c.memDc = CreateCompatibleDC(nullptr);
+	if (!c.dib || !c.memDc || !bits) {
+		releaseCanvas(c);
+		return false;
 	}
+	c.oldBitmap = SelectObject(c.memDc, c.dib);
+	SelectObject(c.memDc, GetStockObject(DEFAULT_GUI_FONT));
+	c.frame = static_cast<std::uint32_t*>(bits);
+	c.width = w;
+	c.height = h;
+
+	const std::uint64_t t0 = monotonicNs();
+	c.background.resize(static_cast<std::size_t>(w) * static_cast<std::size_t>(h));
+	Surface bg = backgroundSurface(c);
+	fillVerticalGradient(bg, kGradientTop, kGradientBottom);
+	std::copy(c.background.begin(), c.background.end(), c.frame);
+	st.paintStats.backgrounds.fetch_add(1, std::memory_order_relaxed);
+	st.paintStats.backgroundNs.fetch_add(monotonicNs() - t0, std::memory_order_relaxed);
+
+	renderSparklines(st);
+	return true;
 }
 
 static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -349,12 +521,41 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
 	switch (msg) {
 	case WM_ERASEBKGND: {
+		if (!st) return DefWindowProcW(hwnd, msg, wParam, lParam);
+		const std::uint64_t t0 = monotonicNs();
 		HDC hdc = reinterpret_cast<HDC>(wParam);
 		RECT rc{};
 		GetClientRect(hwnd, &rc);
-		paintGradientBackground(hdc, rc);
+		if (!ensureCanvas(*st, rc.right - rc.left, rc.bottom - rc.top)) return DefWindowProcW(hwnd, msg, wParam, lParam);
+
+		// Only the invalidated part needs to be copied.
+		RECT clip{};
+		if (GetClipBox(hdc, &clip) == NULLREGION) return 1;
+		GdiFlush();
+		BitBlt(hdc, clip.left, clip.top, clip.right - clip.left, clip.bottom - clip.top, st->canvas.memDc, clip.left, clip.top, SRCCOPY);
+		st->paintStats.erases.fetch_add(1, std::memory_order_relaxed);
+		st->paintStats.eraseNs.fetch_add(monotonicNs() - t0, std::memory_order_relaxed);
+		if (!st->startup.reached(StartupPhase::FirstPaint)) st->startup.mark(StartupPhase::FirstPaint);
 		return 1;
 	}
+	case WM_SAMPLE: {
+		if (!st) return 0;
+		showDeviceInfo(*st);
+		if (st->shownDevice) {
+			const DeviceInfo& d = st->shownDevice->info;
+			st->startup.mark(StartupPhase::FirstDevice);
+			if (d.cpuNameKnown && d.gpuNameKnown && st->startup.reached(StartupPhase::FirstSample)) {
+				st->startup.mark(StartupPhase::DataComplete);
+			}
+		}
+		if (!st->canvas.frame) return 0;
+		renderSparklines(*st);
+		RECT cpuRc = toRect(kCpuSparkRect);
+		RECT memRc = toRect(kMemSparkRect);
+		InvalidateRect(hwnd, &cpuRc, TRUE);
+		InvalidateRect(hwnd, &memRc, TRUE);
+		return 0;
+	}
 	case WM_CTLCOLOREDIT: {
 		HDC hdc = reinterpret_cast<HDC>(wParam);
 		SetBkMode(hdc, OPAQUE);
@@ -390,15 +591,9 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
 		addTrayIcon(*st);
 		updateUi(*st);
-		SetTimer(hwnd, TIMER_ID_SEND, 15000, nullptr); // Refresh every 15s
+		st->startup.mark(StartupPhase::WindowCreated);
 		return 0;
 	}
-	case WM_TIMER:
-		if (wParam == TIMER_ID_SEND && st) {
-			SetWindowTextW(st->hIps, formatDeviceInfo().c_str());
-			RedrawWindow(st->hIps, nullptr, nullptr, RDW_INVALIDATE | RDW_ERASE | RDW_UPDATENOW);
-		}
-		return 0;
 	case WM_COMMAND:
 		if (!st) return 0;
 		if (LOWORD(wParam) == IDC_BTN_TOGGLE) {
@@ -431,7 +626,10 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 	case WM_DESTROY:
 		if (st) {
 			stopServer(*st);
+			stopProbes(*st);
+			stopSampler(*st);
 			removeTrayIcon(*st);
+			releaseCanvas(st->canvas);
 		}
 		PostQuitMessage(0);
 		return 0;
@@ -442,10 +640,15 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
 int RunTrayApp(HINSTANCE hInstance, const UiAppConfig& cfg) {
 	AppState st;
+	st.startup.begin();
 	st.hInst = hInstance;
-	st.cpuMon.init();
 	st.port = cfg.defaultPort;
 	if (st.port < kMinPort || st.port > kMaxPort) st.port = kDefaultPort;
+	st.alerts.setRules(cfg.alertRules);
+	// Room for a burst of transitions, so evaluate() does not grow it on the sampler thread.
+	st.alertScratch.reserve(256);
+	st.serverLimits = cfg.serverLimits;
+	st.serverPolicy = cfg.serverPolicy;
 
 	WNDCLASSW wc{};
 	wc.lpfnWndProc = WndProc;
@@ -454,11 +657,23 @@ int RunTrayApp(HINSTANCE hInstance, const UiAppConfig& cfg) {
 	wc.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
 	wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
 
-	if (!RegisterClassW(&wc)) return 1;
+	createSampler(st);
+	startProbes(st);
+
+	HWND hwnd = nullptr;
+	if (RegisterClassW(&wc)) {
+		hwnd = CreateWindowW(kWndClassName, L"SysMonitor", WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
+			CW_USEDEFAULT, CW_USEDEFAULT, kWndWidth, kWndHeight, nullptr, nullptr, hInstance, &st);
+	}
+	if (!hwnd) {
+		stopProbes(st);
+		stopSampler(st);
+		return 1;
+	}
 
-	HWND hwnd = CreateWindowW(kWndClassName, L"SysMonitor", WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
-		CW_USEDEFAULT, CW_USEDEFAULT, 420, 320, nullptr, nullptr, hInstance, &st); // Increased height here too
-	if (!hwnd) return 1;
+	SamplerConfig samplerCfg = cfg.sampler;
+	watchAlertRules(samplerCfg, cfg.alertRules);
+	startSampler(st, samplerCfg);
 
 	ShowWindow(hwnd, SW_SHOWNORMAL);
 	UpdateWindow(hwnd);
@@ -468,6 +683,8 @@ int RunTrayApp(HINSTANCE hInstance, const UiAppConfig& cfg) {
 		TranslateMessage(&msg);
 		DispatchMessageW(&msg);
 	}
+	stopProbes(st);
+	stopSampler(st);
 	return static_cast<int>(msg.wParam);
 }
 
@@ -1,13 +1,24 @@
 #pragma once
 
+#include "network_server.h"
+#include "sys_alert.h"
+#include "sys_sampler.h"
+#include "sys_thread_policy.h"
+
 #include <windows.h>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace sysmon {
 
 struct UiAppConfig {
 	std::uint16_t defaultPort{ 6666 };
+	SamplerConfig sampler;
+	ServerLimits serverLimits;
+	// Applied to the server thread; the sampler thread has its own in `sampler`.
+	ThreadPolicy serverPolicy;
+	std::vector<AlertRule> alertRules{ defaultAlertRules() };
 };
 
 int RunTrayApp(HINSTANCE hInstance, const UiAppConfig& cfg);
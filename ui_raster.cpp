@@ -0,0 +1,108 @@
+#include "ui_raster.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace sysmon {
+
+RasterRect clipRect(const Surface& s, const RasterRect& rc) {
+	RasterRect out;
+	out.left = std::max(rc.left, 0);
+	out.top = std::max(rc.top, 0);
+	out.right = std::min(rc.right, s.width);
+	out.bottom = std::min(rc.bottom, s.height);
+	if (out.right < out.left) out.right = out.left;
+	if (out.bottom < out.top) out.bottom = out.top;
+	return out;
+}
+
+static std::uint32_t lerpColor(std::uint32_t a, std::uint32_t b, int t, int tmax) {
+	auto ch = [](std::uint32_t c, int shift) { return static_cast<int>((c >> shift) & 0xFF); };
+	const int r = ch(a, 16) + ((ch(b, 16) - ch(a, 16)) * t) / tmax;
+	const int g = ch(a, 8) + ((ch(b, 8) - ch(a, 8)) * t) / tmax;
+	const int bl = ch(a, 0) + ((ch(b, 0) - ch(a, 0)) * t) / tmax;
+	return packRgb(r, g, bl);
+}
+
+void fillVerticalGradient(Surface& s, std::uint32_t top, std::uint32_t bottom) {
+	if (!s.pixels || s.width <= 0 || s.height <= 0) return;
+	for (int y = 0; y < s.height; ++y) {
+		std::uint32_t* row = s.pixels + static_cast<std::ptrdiff_t>(y) * s.stride;
+		std::fill(row, row + s.width, lerpColor(top, bottom, y, s.height));
+	}
+}
+
+void fillRect(Surface& s, const RasterRect& rc, std::uint32_t color) {
+	const RasterRect c = clipRect(s, rc);
+	for (int y = c.top; y < c.bottom; ++y) {
+		std::uint32_t* row = s.pixels + static_cast<std::ptrdiff_t>(y) * s.stride;
+		std::fill(row + c.left, row + c.right, color);
+	}
+}
+
+void copyRect(const Surface& src, Surface& dst, const RasterRect& rc) {
+	if (src.width != dst.width || src.height != dst.height) return;
+	const RasterRect c = clipRect(dst, rc);
+	for (int y = c.top; y < c.bottom; ++y) {
+		const std::uint32_t* from = src.pixels + static_cast<std::ptrdiff_t>(y) * src.stride;
+		std::uint32_t* to = dst.pixels + static_cast<std::ptrdiff_t>(y) * dst.stride;
+		std::copy(from + c.left, from + c.right, to + c.left);
+	}
+}
+
+static void plot(Surface& s, int x, int y, std::uint32_t color) {
+	if (x < 0 || y < 0 || x >= s.width || y >= s.height) return;
+	s.pixels[static_cast<std::ptrdiff_t>(y) * s.stride + x] = color;
+}
+
+void drawLine(Surface& s, int x0, int y0, int x1, int y1, std::uint32_t color) {
+	if (!s.pixels) return;
+	// Bresenham; lines here are a few dozen pixels so per-pixel clipping is fine.
+	const int dx = std::abs(x1 - x0);
+	const int dy = -std::abs(y1 - y0);
+	const int sx = x0 < x1 ? 1 : -1;
+	const int sy = y0 < y1 ? 1 : -1;
+	int err = dx + dy;
+	for (;;) {
+		plot(s, x0, y0, color);
+		if (x0 == x1 && y0 == y1) break;
+		const int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+void drawSparkline(Surface& s, const RasterRect& rc, const double* values, std::size_t count, double minValue, double maxValue, std::uint32_t color) {
+	const int w = rc.right - rc.left;
+	const int h = rc.bottom - rc.top;
+	if (!values || count == 0 || w <= 0 || h <= 0 || maxValue <= minValue) return;
+
+	auto yOf = [&](double v) {
+		v = std::clamp(v, minValue, maxValue);
+		const double t = (v - minValue) / (maxValue - minValue);
+		return rc.bottom - 1 - static_cast<int>(t * (h - 1) + 0.5);
+	};
+	auto xOf = [&](std::size_t i) {
+		if (count == 1) return rc.right - 1;
+		return rc.left + static_cast<int>((static_cast<double>(i) * (w - 1)) / static_cast<double>(count - 1) + 0.5);
+	};
+
+	int px = xOf(0);
+	int py = yOf(values[0]);
+	plot(s, px, py, color);
+	for (std::size_t i = 1; i < count; ++i) {
+		const int x = xOf(i);
+		const int y = yOf(values[i]);
+		drawLine(s, px, py, x, y, color);
+		px = x;
+		py = y;
+	}
+}
+
+} // namespace sysmon
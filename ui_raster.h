@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sysmon {
+
+// Platform-independent software rasterizer for the tray window. Pixels are
+// 0x00RRGGBB, which matches a top-down 32-bit BI_RGB DIB section.
+
+struct Surface {
+	std::uint32_t* pixels{};
+	int width{};
+	int height{};
+	int stride{}; // in pixels
+};
+
+struct RasterRect {
+	int left{};
+	int top{};
+	int right{};  // exclusive
+	int bottom{}; // exclusive
+};
+
+constexpr std::uint32_t packRgb(int r, int g, int b) {
+	return (static_cast<std::uint32_t>(r & 0xFF) << 16) | (static_cast<std::uint32_t>(g & 0xFF) << 8) | static_cast<std::uint32_t>(b & 0xFF);
+}
+
+RasterRect clipRect(const Surface& s, const RasterRect& rc);
+
+// Same integer interpolation the GDI per-scanline version used.
+void fillVerticalGradient(Surface& s, std::uint32_t top, std::uint32_t bottom);
+void fillRect(Surface& s, const RasterRect& rc, std::uint32_t color);
+// Both surfaces must have the same size; used to restore the cached background.
+void copyRect(const Surface& src, Surface& dst, const RasterRect& rc);
+void drawLine(Surface& s, int x0, int y0, int x1, int y1, std::uint32_t color);
+
+// Plots values (oldest first) across rc, scaled so minValue sits on the
+// bottom edge and maxValue on the top edge.
+void drawSparkline(Surface& s, const RasterRect& rc, const double* values, std::size_t count, double minValue, double maxValue, std::uint32_t color);
+
+} // namespace sysmon